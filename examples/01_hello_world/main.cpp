@@ -13,7 +13,10 @@ int main(int argc, char** argv)
         return code;
     }
 
-    g_engine->GetWindow()->SetTitle("01_hello_world");
+    if (auto window = g_engine->GetWindow())
+    {
+        window->SetTitle("01_hello_world");
+    }
 
     return LEGS_Run();
 }
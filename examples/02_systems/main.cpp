@@ -1,3 +1,4 @@
+#include <cmath>
 #include <memory>
 
 #include <legs/entry.hpp>
@@ -17,9 +18,13 @@ class MySystem : public ISystem
   public:
     MySystem()
     {
-        int width;
-        int height;
-        g_engine->GetWindow()->GetFramebufferSize(&width, &height);
+        // Offscreen there is no window, the engine's camera has the size.
+        auto width  = static_cast<int>(g_engine->GetCamera()->viewport.x);
+        auto height = static_cast<int>(g_engine->GetCamera()->viewport.y);
+        if (auto window = g_engine->GetWindow())
+        {
+            window->GetFramebufferSize(&width, &height);
+        }
         m_camera = std::make_shared<NoclipCamera>(width, height);
         m_camera->SetPosition({0.0f, -10.0f, 5.0f});
         g_engine->SetCamera(m_camera);
@@ -31,52 +36,35 @@ class MySystem : public ISystem
         auto sky = std::make_shared<Sky>(renderer);
         world->SetSky(sky);
 
-        // Create some test spheres
+        // Create some test spheres, all sharing one mesh so they get drawn in a single call
+        auto testSphere = SIcosphere(glm::vec3(0.0f), 0.5f, 1);
+
+        std::vector<Vertex_P_N_C> sphereVertices;
+        sphereVertices.reserve(testSphere.positions.size());
+        for (unsigned int i = 0; i < testSphere.positions.size(); i++)
+        {
+            sphereVertices.push_back(
+                {testSphere.positions[i], testSphere.normals[i], glm::vec3(0.5, 0.5, 0.5)}
+            );
+        }
+        auto sphereMesh = renderer->CreateMesh(sphereVertices, testSphere.indices);
+
         for (unsigned int x = 0; x < 3; x++)
         {
             for (unsigned int y = 0; y < 3; y++)
             {
-                auto                    testSphere = SIcosphere(glm::vec3(x, y, 5), 0.5f, 1);
-                std::shared_ptr<Buffer> sphereVertexBuffer;
-                std::shared_ptr<Buffer> sphereIndexBuffer;
-
-                std::vector<Vertex_P_N_C> sphereVertices;
-                sphereVertices.reserve(testSphere.positions.size());
-                for (unsigned int i = 0; i < testSphere.positions.size(); i++)
-                {
-                    sphereVertices.push_back(
-                        {testSphere.positions[i], testSphere.normals[i], glm::vec3(0.5, 0.5, 0.5)}
-                    );
-                }
-                renderer->CreateBuffer(
-                    sphereVertexBuffer,
-                    VertexBuffer,
-                    sphereVertices.data(),
-                    sizeof(Vertex_P_N_C),
-                    static_cast<uint32_t>(sphereVertices.size())
-                );
-                renderer->CreateBuffer(
-                    sphereIndexBuffer,
-                    IndexBuffer,
-                    testSphere.indices.data(),
-                    sizeof(Index),
-                    static_cast<uint32_t>(testSphere.indices.size())
-                );
-
                 auto sphere = std::make_shared<MeshEntity>();
-                sphere->SetBuffers(sphereVertexBuffer, sphereIndexBuffer);
+                sphere->SetMesh(sphereMesh);
                 sphere->SetPipeline(RenderPipeline::GEO_P_N_C);
+                sphere->SetPosition({static_cast<float>(x), static_cast<float>(y), 5.0f});
                 world->AddEntity(sphere);
                 m_spheres.push_back(sphere);
             }
         }
 
         // Create a test plane
-        std::shared_ptr<Buffer> planeVertexBuffer;
-        std::shared_ptr<Buffer> planeIndexBuffer;
-
         auto testPlane     = SPlane({0.0f, 0.0f, 0.0f}, 20.0f);
-        auto planeVertices = std::array<Vertex_P_C, 4>();
+        auto planeVertices = std::vector<Vertex_P_C>(4);
         for (unsigned int i = 0; i < 4; i++)
         {
             auto color = glm::vec3 {
@@ -86,23 +74,10 @@ class MySystem : public ISystem
             };
             planeVertices[i] = {testPlane.vertices[i], color};
         }
-        renderer->CreateBuffer(
-            planeVertexBuffer,
-            VertexBuffer,
-            planeVertices.data(),
-            sizeof(Vertex_P_C),
-            static_cast<uint32_t>(planeVertices.size())
-        );
-        renderer->CreateBuffer(
-            planeIndexBuffer,
-            IndexBuffer,
-            testPlane.indices.data(),
-            sizeof(Index),
-            static_cast<uint32_t>(testPlane.indices.size())
-        );
+        auto planeIndices = std::vector<Index>(testPlane.indices.begin(), testPlane.indices.end());
 
         auto plane = std::make_shared<MeshEntity>();
-        plane->SetBuffers(planeVertexBuffer, planeIndexBuffer);
+        plane->SetMesh(renderer->CreateMesh(planeVertices, planeIndices));
         plane->SetPipeline(RenderPipeline::GEO_P_C);
         world->AddEntity(plane);
     }
@@ -115,17 +90,6 @@ class MySystem : public ISystem
     {
         m_camera->HandleInput(g_engine->GetFrameInput());
 
-        // TODO: model matrix buffer
-        // Move the spheres around
-        /*
-        for (unsigned int i = 0; i < m_spheres.size(); i++)
-        {
-            auto pos = m_spheres[i]->GetPosition();
-            pos.z    = static_cast<float>(std::sin(legs::Time::Uptime() * i));
-            m_spheres[i]->SetPosition(pos);
-        }
-        */
-
         // Move the sun across the sky
         const auto degreesPerSecond = 5.0;
         auto       sunRotation      = glm::angleAxis(
@@ -138,6 +102,13 @@ class MySystem : public ISystem
 
     void OnTick() override
     {
+        // Move the spheres around
+        for (unsigned int i = 0; i < m_spheres.size(); i++)
+        {
+            auto pos = m_spheres[i]->GetPosition();
+            pos.z    = 5.0f + static_cast<float>(std::sin(legs::Time::Uptime() * i));
+            m_spheres[i]->SetPosition(pos);
+        }
     }
 
   private:
@@ -155,7 +126,10 @@ int main(int argc, char** argv)
         return code;
     }
 
-    g_engine->GetWindow()->SetTitle("02_systems");
+    if (auto window = g_engine->GetWindow())
+    {
+        window->SetTitle("02_systems");
+    }
 
     g_engine->AddSystem(std::make_shared<MySystem>());
 
@@ -16,49 +16,51 @@ class MySystem : public ISystem
   public:
     MySystem()
     {
-        int width;
-        int height;
-        g_engine->GetWindow()->GetFramebufferSize(&width, &height);
-        m_camera = std::make_shared<NoclipCamera>(width, height);
-        m_camera->SetPosition({0.0f, -10.0f, 5.0f});
-        g_engine->SetCamera(m_camera);
+        if (auto window = g_engine->GetWindow())
+        {
+            int width;
+            int height;
+            window->GetFramebufferSize(&width, &height);
+            m_camera = std::make_shared<NoclipCamera>(width, height);
+            m_camera->SetPosition({0.0f, -10.0f, 5.0f});
+            g_engine->SetCamera(m_camera);
+        }
 
         auto renderer = g_engine->GetRenderer();
         auto world    = g_engine->GetWorld();
 
         // Create a plane
-        std::shared_ptr<Buffer> planeVertexBuffer;
-        std::shared_ptr<Buffer> planeIndexBuffer;
+        auto plane = std::make_shared<PhysicsEntity>();
 
-        auto testPlane     = SPlane({0.0f, 0.0f, 0.0f}, 20.0f);
-        auto planeVertices = std::array<Vertex_P_C, 4>();
-        for (unsigned int i = 0; i < 4; i++)
+        // No renderer when running headless
+        if (renderer != nullptr)
         {
-            auto color = glm::vec3 {
-                i == 0 ? 1.0f : 0.0f,
-                i == 1 ? 1.0f : 0.0f,
-                i == 2 ? 1.0f : 0.0f,
-            };
-            planeVertices[i] = {testPlane.vertices[i], color};
+            std::shared_ptr<Buffer> planeVertexBuffer;
+            std::shared_ptr<Buffer> planeIndexBuffer;
+
+            auto testPlane     = SPlane({0.0f, 0.0f, 0.0f}, 20.0f);
+            auto planeVertices = std::vector<Vertex_P_C>(4);
+            for (unsigned int i = 0; i < 4; i++)
+            {
+                auto color = glm::vec3 {
+                    i == 0 ? 1.0f : 0.0f,
+                    i == 1 ? 1.0f : 0.0f,
+                    i == 2 ? 1.0f : 0.0f,
+                };
+                planeVertices[i] = {testPlane.vertices[i], color};
+            }
+            SBoundingSphere planeBounds;
+            renderer->CreateVertexBuffer(planeVertexBuffer, planeVertices, planeBounds);
+            renderer->CreateBuffer(
+                planeIndexBuffer,
+                IndexBuffer,
+                testPlane.indices.data(),
+                sizeof(Index),
+                static_cast<uint32_t>(testPlane.indices.size())
+            );
+            plane->SetBuffers(planeVertexBuffer, planeIndexBuffer, planeBounds);
+            plane->SetPipeline(RenderPipeline::GEO_P_C);
         }
-        renderer->CreateBuffer(
-            planeVertexBuffer,
-            VertexBuffer,
-            planeVertices.data(),
-            sizeof(Vertex_P_C),
-            static_cast<uint32_t>(planeVertices.size())
-        );
-        renderer->CreateBuffer(
-            planeIndexBuffer,
-            IndexBuffer,
-            testPlane.indices.data(),
-            sizeof(Index),
-            static_cast<uint32_t>(testPlane.indices.size())
-        );
-
-        auto plane = std::make_shared<PhysicsEntity>();
-        plane->SetBuffers(planeVertexBuffer, planeIndexBuffer);
-        plane->SetPipeline(RenderPipeline::GEO_P_C);
 
         auto planeCollider = BoxCollider(
             JPH::EMotionType::Static,
@@ -71,36 +73,37 @@ class MySystem : public ISystem
         world->AddEntity(plane);
 
         // Create a sphere
-        auto                    testSphere = SIcosphere(glm::vec3(0.0f, 0.0f, 10.0f), 0.5f, 1);
-        std::shared_ptr<Buffer> sphereVertexBuffer;
-        std::shared_ptr<Buffer> sphereIndexBuffer;
+        auto testSphere = SIcosphere(glm::vec3(0.0f), 0.5f, 1);
+        auto sphere     = std::make_shared<PhysicsEntity>();
 
-        std::vector<Vertex_P_N_C> sphereVertices;
-        sphereVertices.reserve(testSphere.positions.size());
-        for (unsigned int i = 0; i < testSphere.positions.size(); i++)
+        // The body doesn't exist yet, place the transform it gets created from.
+        sphere->GetTransform()->position = {0.0f, 0.0f, 10.0f};
+
+        if (renderer != nullptr)
         {
-            sphereVertices.push_back(
-                {testSphere.positions[i], testSphere.normals[i], glm::vec3(0.5, 0.5, 0.5)}
+            std::shared_ptr<Buffer> sphereVertexBuffer;
+            std::shared_ptr<Buffer> sphereIndexBuffer;
+
+            std::vector<Vertex_P_N_C> sphereVertices;
+            sphereVertices.reserve(testSphere.positions.size());
+            for (unsigned int i = 0; i < testSphere.positions.size(); i++)
+            {
+                sphereVertices.push_back(
+                    {testSphere.positions[i], testSphere.normals[i], glm::vec3(0.5, 0.5, 0.5)}
+                );
+            }
+            SBoundingSphere sphereBounds;
+            renderer->CreateVertexBuffer(sphereVertexBuffer, sphereVertices, sphereBounds);
+            renderer->CreateBuffer(
+                sphereIndexBuffer,
+                IndexBuffer,
+                testSphere.indices.data(),
+                sizeof(Index),
+                static_cast<uint32_t>(testSphere.indices.size())
             );
+            sphere->SetBuffers(sphereVertexBuffer, sphereIndexBuffer, sphereBounds);
+            sphere->SetPipeline(RenderPipeline::GEO_P_N_C);
         }
-        renderer->CreateBuffer(
-            sphereVertexBuffer,
-            VertexBuffer,
-            sphereVertices.data(),
-            sizeof(Vertex_P_N_C),
-            static_cast<uint32_t>(sphereVertices.size())
-        );
-        renderer->CreateBuffer(
-            sphereIndexBuffer,
-            IndexBuffer,
-            testSphere.indices.data(),
-            sizeof(Index),
-            static_cast<uint32_t>(testSphere.indices.size())
-        );
-
-        auto sphere = std::make_shared<PhysicsEntity>();
-        sphere->SetBuffers(sphereVertexBuffer, sphereIndexBuffer);
-        sphere->SetPipeline(RenderPipeline::GEO_P_N_C);
 
         auto sphereCollider =
             SphereCollider(JPH::EMotionType::Dynamic, Layers::MOVING, sphere->GetTransform(), 0.5f);
@@ -115,7 +118,10 @@ class MySystem : public ISystem
 
     void OnFrame() override
     {
-        m_camera->HandleInput(g_engine->GetFrameInput());
+        if (m_camera != nullptr)
+        {
+            m_camera->HandleInput(g_engine->GetFrameInput());
+        }
     }
 
   private:
@@ -132,7 +138,10 @@ int main(int argc, char** argv)
         return code;
     }
 
-    g_engine->GetWindow()->SetTitle("03_systems");
+    if (auto window = g_engine->GetWindow())
+    {
+        window->SetTitle("03_systems");
+    }
 
     g_engine->AddSystem(std::make_shared<MySystem>());
 
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <filesystem>
+#include <format>
 #include <functional>
 #include <memory>
 #include <stop_token>
@@ -14,34 +17,92 @@
 
 namespace legs
 {
-Engine::Engine()
+Engine::Engine(EngineSettings settings) :
+    m_settings(settings),
+    m_frameQueue(settings.pipelineDepth),
+    m_tickQueue(settings.pipelineDepth)
 {
     LOG_INFO("Creating Engine");
 
+    if (m_settings.headless)
+    {
+        LOG_INFO("Running headless");
+
+        Physics::Register();
+        m_world = std::make_shared<World>(nullptr);
+        m_world->SetParallelTick(m_settings.parallelEntityTick);
+
+        LOG_DEBUG("Setting tickrate to {}", m_settings.tickRate);
+        if (!Time::SetTickRate(m_settings.tickRate))
+        {
+            LOG_WARN("Invalid tickrate {}, using {}", m_settings.tickRate, Time::TickRate);
+        }
+
+        Time::SetStart();
+
+        m_tickInput.Clear();
+        return;
+    }
+
     m_inputSettings = std::make_shared<InputSettings>();
-    m_window        = std::make_shared<Window>(m_inputSettings);
-    m_renderer      = std::make_shared<Renderer>(m_window);
 
-    int width;
-    int height;
-    m_window->GetFramebufferSize(&width, &height);
-    m_camera = std::make_shared<Camera>(width, height);
+    int width  = static_cast<int>(m_settings.offscreenWidth);
+    int height = static_cast<int>(m_settings.offscreenHeight);
+    if (m_settings.offscreen)
+    {
+        LOG_INFO("Rendering offscreen");
+
+        const VkExtent2D extent {m_settings.offscreenWidth, m_settings.offscreenHeight};
+        m_renderer = std::make_shared<Renderer>(nullptr, extent);
+
+        if (m_settings.readbackInterval > 0 && !m_settings.onReadback)
+        {
+            std::error_code error;
+            std::filesystem::create_directories(m_settings.readbackDirectory, error);
+        }
+    }
+    else
+    {
+        m_window   = std::make_shared<Window>(m_inputSettings);
+        m_renderer = std::make_shared<Renderer>(m_window);
+        m_window->GetFramebufferSize(&width, &height);
 
-    m_ui = std::make_unique<UI>(m_window, m_renderer);
+        m_ui = std::make_unique<UI>(m_window, m_renderer);
+        m_ui->SetSystemSchedulers(&m_frameSystems, &m_tickSystems);
+    }
+
+    m_camera = std::make_shared<Camera>(width, height);
 
     Physics::Register();
     m_world = std::make_shared<World>(m_renderer);
+    m_world->SetParallelTick(m_settings.parallelEntityTick);
 
-    m_window->SetMouseGrab(true);
+    LOG_DEBUG("Setting tickrate to {}", m_settings.tickRate);
+    if (!Time::SetTickRate(m_settings.tickRate))
+    {
+        LOG_WARN("Invalid tickrate {}, using {}", m_settings.tickRate, Time::TickRate);
+    }
 
-    auto fps = m_window->GetRefreshRate();
+    // Nothing to sync to offscreen, frames keep up with ticks.
+    auto fps = Time::TickRate;
+    if (m_window != nullptr)
+    {
+        m_window->SetMouseGrab(true);
+        fps = m_window->GetRefreshRate();
+    }
     LOG_DEBUG("Setting framerate to {}", fps);
-    Time::SetFrameRate(fps);
+    if (!Time::SetFrameRate(fps))
+    {
+        LOG_WARN("Invalid framerate {}, using {}", fps, Time::FrameRate);
+    }
 
     Time::SetStart();
 
     m_frameInput.Clear();
     m_tickInput.Clear();
+    m_pendingTickInput.Clear();
+
+    LOG_DEBUG("Pipeline depth {}", m_frameQueue.Depth());
 
     m_tickThread   = std::jthread {std::bind_front(&Engine::TickThread, this)};
     m_renderThread = std::jthread {std::bind_front(&Engine::RenderThread, this)};
@@ -51,40 +112,64 @@ Engine::~Engine()
 {
     LOG_INFO("Destroying Engine");
 
-    LOG_DEBUG("Requesting TickThread stop");
-    m_tickThread.request_stop();
-    m_threadTickSemaphore.release();
-    m_tickThread.join();
+    if (m_tickThread.joinable())
+    {
+        LOG_DEBUG("Requesting TickThread stop");
+        m_tickThread.request_stop();
+        m_tickQueue.Close();
+        m_tickThread.join();
+    }
 
-    LOG_DEBUG("Requesting RenderThread stop");
-    m_renderThread.request_stop();
-    m_threadFrameSemaphore.release();
-    m_renderThread.join();
+    if (m_renderThread.joinable())
+    {
+        // Closing without a stop request lets the render thread finish the queued frames,
+        // offscreen runs would otherwise lose their last readbacks.
+        LOG_DEBUG("Closing RenderThread queue");
+        m_frameQueue.Close();
+        m_renderThread.join();
+    }
 
-    LOG_DEBUG("Waiting for renderer idle");
-    m_renderer->WaitForIdle();
+    if (m_renderer != nullptr)
+    {
+        LOG_DEBUG("Waiting for renderer idle");
+        m_renderer->WaitForIdle();
+    }
 }
 
 int Engine::Run()
 {
-    m_mainFrameSemaphore.release();
-    m_mainTickSemaphore.release();
+    if (m_settings.headless)
+    {
+        return RunHeadless();
+    }
 
     Time::UpdateTickDelta();
     Time::UpdateFrameDelta();
 
+    m_previousTickTime = Time::Now();
+
     const double sleepThreshold = 0.0001;
-    while (true)
+    while (!m_stopRequested)
     {
-        auto toTick = Time::TimeToEngineTick();
-        if (toTick <= 0)
+        if (m_pendingTickInput.wantsQuit)
         {
-            if (!Tick())
-            {
-                LOG_INFO("Engine::Tick exit");
-                break;
-            }
-            toTick = Time::TickInterval;
+            LOG_INFO("Engine::Tick exit");
+            break;
+        }
+
+        if (m_settings.maxFrames > 0 && m_frameCount >= m_settings.maxFrames)
+        {
+            LOG_INFO("Queued {} frames", m_frameCount);
+            break;
+        }
+
+        UpdateTickAccumulator();
+
+        // Queue as many fixed steps as have accumulated,
+        // the remainder is used for interpolating between ticks.
+        while (m_tickAccumulator >= Time::TickInterval && Tick())
+        {
+            m_tickAccumulator -= Time::TickInterval;
         }
 
         auto toFrame = Time::TimeToEngineFrame();
@@ -94,6 +179,7 @@ int Engine::Run()
             toFrame = Time::FrameInterval;
         }
 
+        const auto toTick = Time::TickInterval - m_tickAccumulator;
         const auto lowest = std::min(toTick, toFrame);
         if (lowest < sleepThreshold)
         {
@@ -108,23 +194,97 @@ int Engine::Run()
     return 0;
 }
 
+int Engine::RunHeadless()
+{
+    const auto   start          = Time::Now();
+    const double sleepThreshold = 0.0001;
+    uint64_t     ticks          = 0;
+
+    m_previousTickTime = start;
+
+    while (!m_stopRequested)
+    {
+        if (m_settings.maxTicks > 0 && ticks >= m_settings.maxTicks)
+        {
+            break;
+        }
+
+        if (!m_settings.uncappedTickRate)
+        {
+            UpdateTickAccumulator();
+
+            const auto toTick = Time::TickInterval - m_tickAccumulator;
+            if (toTick > sleepThreshold)
+            {
+                std::this_thread::sleep_for(Time::Duration(toTick - sleepThreshold));
+                continue;
+            }
+            if (toTick > 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            m_tickAccumulator -= Time::TickInterval;
+        }
+
+        Time::DeltaTick = Time::TickInterval;
+
+        RunTick();
+        ticks++;
+    }
+
+    const auto elapsed = Time::Now() - start;
+    LOG_INFO(
+        "Ran {} ticks in {:.3f}s ({:.0f} TPS, {:.3f} ms/tick)",
+        ticks,
+        elapsed,
+        elapsed > 0.0 ? static_cast<double>(ticks) / elapsed : 0.0,
+        ticks > 0 ? 1000.0 * elapsed / static_cast<double>(ticks) : 0.0
+    );
+
+    return 0;
+}
+
+void Engine::UpdateTickAccumulator()
+{
+    const auto now = Time::Now();
+    m_tickAccumulator += now - m_previousTickTime;
+    m_previousTickTime = now;
+
+    // Drop time instead of queueing a burst of catch-up ticks
+    // that would only make the simulation fall further behind.
+    const auto maxAccumulated = Time::TickInterval * m_settings.maxCatchUpTicks;
+    if (m_tickAccumulator > maxAccumulated)
+    {
+        LOG_WARN(
+            "Simulation fell behind, dropping {:.2f}ms",
+            1000.0 * (m_tickAccumulator - maxAccumulated)
+        );
+        m_tickAccumulator = maxAccumulated;
+    }
+}
+
 void Engine::Frame()
 {
-    // Renderer still busy?
-    auto acquired = m_mainFrameSemaphore.try_acquire();
-    if (!acquired)
+    // Renderer is a whole queue behind, wait for a slot but not past the next tick.
+    const auto timeout = Time::Duration(std::max(Time::TickInterval - m_tickAccumulator, 0.0));
+    auto       context = m_frameQueue.TryBeginWrite(timeout);
+    if (context == nullptr)
     {
         return;
     }
 
     Time::UpdateFrameDelta();
 
-    UpdateInput();
+    // Slot is reused, clear what the render thread applied last time.
+    context->resize = false;
+    context->toggleWindow.fill(false);
+    context->uiEvents.clear();
 
-    for (auto system : m_systems)
-    {
-        system->OnFrame();
-    }
+    UpdateInput(context->uiEvents);
+
+    m_frameSystems.Run(GetJobSystem());
 
     if (m_frameInput.wantsResize)
     {
@@ -132,7 +292,7 @@ void Engine::Frame()
         int height;
         m_window->GetFramebufferSize(&width, &height);
         m_camera->UpdateViewport(width, height);
-        m_renderer->Resize();
+        context->resize = true;
     }
 
     if (m_world != nullptr)
@@ -149,56 +309,143 @@ void Engine::Frame()
 
     if (m_frameInput.HasKey(Key::KEY_WINDOW_DEBUG))
     {
-        m_ui->ToggleWindow(UIWindow::DEBUG);
+        context->toggleWindow[static_cast<size_t>(UIWindow::DEBUG)] = true;
         m_frameInput.KeyUp(Key::KEY_WINDOW_DEBUG);
     }
 
+    if (m_frameInput.HasKey(Key::KEY_WINDOW_SYSTEMS))
+    {
+        context->toggleWindow[static_cast<size_t>(UIWindow::SYSTEMS)] = true;
+        m_frameInput.KeyUp(Key::KEY_WINDOW_SYSTEMS);
+    }
+
     if (m_frameInput.HasKey(Key::KEY_WINDOW_DEMO))
     {
         m_window->SetMouseGrab(false);
         m_frameInput.Clear();
-        m_ui->ToggleWindow(UIWindow::DEMO);
+        context->toggleWindow[static_cast<size_t>(UIWindow::DEMO)] = true;
     }
 
     m_frameInput.Clear();
 
-    // Allow render thread to run.
-    m_threadFrameSemaphore.release();
+    context->frame             = m_frameCount++;
+    context->time              = m_simulationTime + m_tickAccumulator;
+    context->frameUbo.sunColor = {};
+    context->frameUbo.sunDir   = {};
+
+    if (m_world != nullptr)
+    {
+        if (auto sky = m_world->GetSky())
+        {
+            context->frameUbo.sunDir   = sky->SunDirection;
+            context->frameUbo.sunColor = sky->SunColor;
+        }
+    }
+
+    if (m_camera != nullptr && (m_viewDirty || m_camera->GetVersion() != m_viewCameraVersion))
+    {
+        m_view.SetCamera(m_camera);
+        m_viewCameraVersion = m_camera->GetVersion();
+        m_viewDirty         = false;
+        m_viewRevision++;
+    }
+
+    context->view         = m_view;
+    context->viewRevision = m_viewRevision;
+
+    // Hand the frame over to the render thread.
+    m_frameQueue.EndWrite();
 }
 
 bool Engine::Tick()
 {
-    if (m_tickInput.wantsQuit)
+    // Tick thread is a whole queue behind,
+    // leave the time in the accumulator and try again next loop.
+    auto context = m_tickQueue.TryBeginWrite();
+    if (context == nullptr)
     {
         return false;
     }
 
-    // Tick thread still busy?
-    auto acquired = m_mainTickSemaphore.try_acquire();
-    if (!acquired)
+    context->tick  = m_tickCount++;
+    context->delta = Time::TickInterval;
+    context->input = m_pendingTickInput;
+    m_pendingTickInput.Clear();
+
+    m_simulationTime += Time::TickInterval;
+
+    // Hand the tick over to the tick thread.
+    m_tickQueue.EndWrite();
+
+    return true;
+}
+
+void Engine::UpdateInput(std::vector<SDL_Event>& uiEvents)
+{
+    if (m_window != nullptr)
     {
-        return true;
+        m_window->AggregateInput(m_frameInput, uiEvents);
     }
+    m_pendingTickInput.Aggregate(m_frameInput);
+}
 
-    const auto delta         = Time::TimeSinceEngineTick();
-    const auto slowThreshold = Time::TickInterval * 2.0;
-    if (delta > slowThreshold)
+void Engine::ApplyFrameChanges(const FrameContext& context)
+{
+    if (context.resize)
     {
-        LOG_WARN("Tick thread ran slow: {:.2f}ms", 1000 * Time::TimeSinceEngineTick());
+        m_renderer->Resize();
     }
 
-    Time::UpdateTickDelta();
+    if (m_ui == nullptr)
+    {
+        return;
+    }
 
-    // Allow tick thread to run.
-    m_threadTickSemaphore.release();
+    m_ui->ProcessEvents(context.uiEvents);
+    for (size_t i = 0; i < context.toggleWindow.size(); i++)
+    {
+        if (context.toggleWindow[i])
+        {
+            m_ui->ToggleWindow(static_cast<UIWindow>(i));
+        }
+    }
+}
 
-    return true;
+void Engine::OnReadback(uint64_t frame, const SReadbackImage& image)
+{
+    if (m_settings.onReadback)
+    {
+        m_settings.onReadback(frame, image);
+        return;
+    }
+
+    const auto path =
+        std::filesystem::path(m_settings.readbackDirectory) / std::format("frame_{}.ppm", frame);
+    if (WritePPM(path.string(), image))
+    {
+        LOG_DEBUG("Wrote {}", path.string());
+    }
 }
 
-void Engine::UpdateInput()
+JPH::JobSystem* Engine::GetJobSystem()
 {
-    m_window->AggregateInput(m_frameInput);
-    m_tickInput.Aggregate(m_frameInput);
+    if (m_world == nullptr)
+    {
+        return nullptr;
+    }
+    return m_world->GetPhysics()->GetJobSystem();
+}
+
+void Engine::RunTick()
+{
+    m_tickSystems.Run(GetJobSystem());
+
+    if (m_world != nullptr)
+    {
+        m_world->Tick();
+    }
+
+    m_tickInput.Clear();
 }
 
 void Engine::TickThread(const std::stop_token token)
@@ -208,23 +455,22 @@ void Engine::TickThread(const std::stop_token token)
     while (!token.stop_requested())
     {
         // Wait for main thread.
-        m_threadTickSemaphore.acquire();
-
-        for (auto system : m_systems)
+        auto context = m_tickQueue.BeginRead();
+        if (context == nullptr)
         {
-            system->OnTick();
+            break;
         }
 
-        if (m_world != nullptr)
-        {
-            m_world->Tick();
-        }
+        Time::DeltaTick = context->delta;
+        m_tickInput     = context->input;
 
-        m_tickInput.Clear();
+        RunTick();
 
-        // Let main thread know we are done.
-        m_mainTickSemaphore.release();
+        // Let main thread reuse the slot.
+        m_tickQueue.EndRead();
     }
+
+    LOG_INFO("Exit TickThread");
 }
 
 void Engine::RenderThread(const std::stop_token token)
@@ -234,55 +480,59 @@ void Engine::RenderThread(const std::stop_token token)
     while (!token.stop_requested())
     {
         // Wait for main thread.
-        m_threadFrameSemaphore.acquire();
+        auto context = m_frameQueue.BeginRead();
+        if (context == nullptr)
+        {
+            break;
+        }
 
         Time::StartRender();
 
-        if (m_window->IsMinimized())
+        // Also for skipped frames, so no resize or UI input gets lost.
+        ApplyFrameChanges(*context);
+
+        if (m_window != nullptr && m_window->IsMinimized())
         {
             Time::StopRender();
-            m_mainFrameSemaphore.release();
+            m_frameQueue.EndRead();
             continue;
         }
 
         m_renderer->Begin();
 
-        auto ubo = m_renderer->GetUBO();
-
-        ubo->sunColor = {};
-        ubo->sunDir   = {};
+        *m_renderer->GetFrameUBO() = context->frameUbo;
+        m_renderer->SetView(context->view, context->viewRevision);
+        m_renderer->UpdateUBO();
 
         if (m_world != nullptr)
         {
-            if (auto sky = m_world->GetSky())
-            {
-                ubo->sunDir   = sky->SunDirection;
-                ubo->sunColor = sky->SunColor;
-            }
+            m_world->Render(context->time);
         }
 
-        if (m_camera != nullptr)
+        if (m_ui != nullptr)
         {
-            ubo->SetCamera(m_camera);
+            m_ui->Render();
         }
 
-        m_renderer->UpdateUBO();
-
-        if (m_world != nullptr)
+        const auto interval = m_settings.readbackInterval;
+        if (m_renderer->IsOffscreen() && interval > 0 && context->frame % interval == 0)
         {
-            m_world->Render();
+            m_renderer->ReadbackFrame(
+                [this, frame = context->frame](const SReadbackImage& image)
+                {
+                    OnReadback(frame, image);
+                }
+            );
         }
 
-        m_ui->Render();
-
         m_renderer->Submit();
 
         m_renderer->Present();
 
         Time::StopRender();
 
-        // Let main thread know we are done.
-        m_mainFrameSemaphore.release();
+        // Let main thread reuse the slot.
+        m_frameQueue.EndRead();
     }
 
     LOG_INFO("Exit RenderThread");
@@ -18,6 +18,11 @@ using namespace JPH;
 namespace legs
 {
 
+// Pool and queue index of the worker running on this thread, so jobs queued from within a job can
+// go on the worker's own queue
+static thread_local const JobSystemThreadPool* currentPool        = nullptr;
+static thread_local int                        currentThreadIndex = -1;
+
 void JobSystemThreadPool::Init(uint inMaxJobs, uint inMaxBarriers, int inNumThreads)
 {
     JobSystemWithBarrier::Init(inMaxBarriers);
@@ -25,12 +30,6 @@ void JobSystemThreadPool::Init(uint inMaxJobs, uint inMaxBarriers, int inNumThre
     // Init freelist of jobs
     mJobs.Init(inMaxJobs, inMaxJobs);
 
-    // Init queue
-    for (std::atomic<Job*>& j : mQueue)
-    {
-        j = nullptr;
-    }
-
     // Start the worker threads
     StartThreads(inNumThreads);
 }
@@ -60,14 +59,9 @@ void JobSystemThreadPool::StartThreads([[maybe_unused]] int inNumThreads)
     // Don't quit the threads
     mQuit = false;
 
-    // Allocate heads
-    mHeads =
-        reinterpret_cast<std::atomic<uint>*>(JPH::Allocate(sizeof(std::atomic<uint>) * inNumThreads)
-        );
-    for (int i = 0; i < inNumThreads; ++i)
-    {
-        mHeads[i] = 0;
-    }
+    // Allocate a queue per thread, before the threads start so they never see a partial array
+    mQueues    = new JobQueue[inNumThreads];
+    mNumQueues = uint(inNumThreads);
 
     // Start running threads
     JPH_ASSERT(mThreads.empty());
@@ -108,23 +102,25 @@ void JobSystemThreadPool::StopThreads()
     // Delete all threads
     mThreads.clear();
 
-    // Ensure that there are no lingering jobs in the queue
-    for (uint head = 0; head != mTail; ++head)
+    // Ensure that there are no lingering jobs in the queues, the owners are gone so steal them
+    auto drain = [](JobQueue& ioQueue)
     {
-        // Fetch job
-        Job* job_ptr = mQueue[head & (cQueueLength - 1)].exchange(nullptr);
-        if (job_ptr != nullptr)
+        while (Job* job_ptr = ioQueue.Steal())
         {
-            // And execute it
             job_ptr->Execute();
             job_ptr->Release();
         }
+    };
+    for (uint i = 0; i < mNumQueues; ++i)
+    {
+        drain(mQueues[i]);
     }
+    drain(mInjectedJobs);
 
-    // Destroy heads and reset tail
-    JPH::Free(mHeads);
-    mHeads = nullptr;
-    mTail  = 0;
+    // Destroy queues
+    delete[] mQueues;
+    mQueues    = nullptr;
+    mNumQueues = 0;
 }
 
 JPH::JobHandle JobSystemThreadPool::CreateJob(
@@ -168,66 +164,31 @@ void JobSystemThreadPool::FreeJob(Job* inJob)
     mJobs.DestructObject(inJob);
 }
 
-uint JobSystemThreadPool::GetHead() const
+void JobSystemThreadPool::QueueJobsInternal(Job** inJobs, uint inNumJobs)
 {
-    // Find the minimal value across all threads
-    uint head = mTail;
-    for (size_t i = 0; i < mThreads.size(); ++i)
+    // Add reference to jobs because we're adding them to a queue
+    for (uint i = 0; i < inNumJobs; ++i)
     {
-        head = std::min(head, mHeads[i].load());
+        inJobs[i]->AddRef();
     }
-    return head;
-}
-
-void JobSystemThreadPool::QueueJobInternal(Job* inJob)
-{
-    // Add reference to job because we're adding the job to the queue
-    inJob->AddRef();
 
-    // Need to read head first because otherwise the tail can already have passed the head
-    // We read the head outside of the loop since it involves iterating over all threads and we only
-    // need to update it if there's not enough space in the queue.
-    uint head = GetHead();
-
-    for (;;)
+    // A worker owns its queue, so it can push without contention. The queues grow when full so
+    // there is no need to wait for other threads to make space.
+    if (currentPool == this)
     {
-        // Check if there's space in the queue
-        uint old_value = mTail;
-        if (old_value - head >= cQueueLength)
+        JobQueue& queue = mQueues[currentThreadIndex];
+        for (uint i = 0; i < inNumJobs; ++i)
         {
-            // We calculated the head outside of the loop, update head (and we also need to update
-            // tail to prevent it from passing head)
-            head      = GetHead();
-            old_value = mTail;
-
-            // Second check if there's space in the queue
-            if (old_value - head >= cQueueLength)
-            {
-                // Wake up all threads in order to ensure that they can clear any nullptrs they may
-                // not have processed yet
-                mSemaphore.Release((uint)mThreads.size());
-
-                // Sleep a little (we have to wait for other threads to update their head pointer in
-                // order for us to be able to continue)
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
-                continue;
-            }
+            queue.Push(inJobs[i]);
         }
+        return;
+    }
 
-        // Write the job pointer if the slot is empty
-        Job* expected_job = nullptr;
-        bool success =
-            mQueue[old_value & (cQueueLength - 1)].compare_exchange_strong(expected_job, inJob);
-
-        // Regardless of who wrote the slot, we will update the tail (if the successful thread got
-        // scheduled out after writing the pointer we still want to be able to continue)
-        mTail.compare_exchange_strong(old_value, old_value + 1);
-
-        // If we successfully added our job we're done
-        if (success)
-        {
-            break;
-        }
+    // Other threads share the injected queue, only one of them can push at a time
+    std::lock_guard lock(mInjectedMutex);
+    for (uint i = 0; i < inNumJobs; ++i)
+    {
+        mInjectedJobs.Push(inJobs[i]);
     }
 }
 
@@ -244,7 +205,7 @@ void JobSystemThreadPool::QueueJob(Job* inJob)
     }
 
     // Queue the job
-    QueueJobInternal(inJob);
+    QueueJobsInternal(&inJob, 1);
 
     // Wake up thread
     mSemaphore.Release();
@@ -265,15 +226,62 @@ void JobSystemThreadPool::QueueJobs(Job** inJobs, uint inNumJobs)
     }
 
     // Queue all jobs
-    for (Job **job = inJobs, **job_end = inJobs + inNumJobs; job < job_end; ++job)
-    {
-        QueueJobInternal(*job);
-    }
+    QueueJobsInternal(inJobs, inNumJobs);
 
     // Wake up threads
     mSemaphore.Release(std::min(inNumJobs, (uint)mThreads.size()));
 }
 
+JPH::JobSystem::Job* JobSystemThreadPool::FindJob(int inThreadIndex, uint32_t& ioRandom)
+{
+    for (;;)
+    {
+        // Newest job of our own queue first, it is most likely still in cache
+        if (Job* job = mQueues[inThreadIndex].Pop())
+        {
+            return job;
+        }
+
+        // Then jobs queued from outside the pool
+        if (Job* job = mInjectedJobs.Steal())
+        {
+            return job;
+        }
+
+        // Then steal the oldest job of another worker, starting at a random one so thieves spread
+        // out over the victims
+        ioRandom ^= ioRandom << 13;
+        ioRandom ^= ioRandom >> 17;
+        ioRandom ^= ioRandom << 5;
+        uint start = ioRandom % mNumQueues;
+        for (uint i = 0; i < mNumQueues; ++i)
+        {
+            uint victim = (start + i) % mNumQueues;
+            if (victim == uint(inThreadIndex))
+            {
+                continue;
+            }
+
+            if (Job* job = mQueues[victim].Steal())
+            {
+                return job;
+            }
+        }
+
+        // A steal can fail because another thread took the same job, only give up when there
+        // really is nothing left
+        bool empty = mInjectedJobs.IsEmpty();
+        for (uint i = 0; i < mNumQueues && empty; ++i)
+        {
+            empty = mQueues[i].IsEmpty();
+        }
+        if (empty)
+        {
+            return nullptr;
+        }
+    }
+}
+
 static void SetThreadName(const char* inName)
 {
     JPH_ASSERT(strlen(inName) < 16); // String will be truncated if it is longer
@@ -299,7 +307,12 @@ void JobSystemThreadPool::ThreadMain(int inThreadIndex)
     // Call the thread init function
     mThreadInitFunction(inThreadIndex);
 
-    std::atomic<uint>& head = mHeads[inThreadIndex];
+    // Jobs queued from this thread go on our own queue
+    currentPool        = this;
+    currentThreadIndex = inThreadIndex;
+
+    // Seed for picking steal victims, xorshift needs it to be nonzero
+    uint32_t random = uint32_t(inThreadIndex) * 0x9E3779B9u + 1;
 
     while (!mQuit)
     {
@@ -309,26 +322,18 @@ void JobSystemThreadPool::ThreadMain(int inThreadIndex)
         {
             JPH_PROFILE("Executing Jobs");
 
-            // Loop over the queue
-            while (head != mTail)
+            // Run jobs until all queues are empty
+            while (Job* job_ptr = FindJob(inThreadIndex, random))
             {
-                // Exchange any job pointer we find with a nullptr
-                std::atomic<Job*>& job = mQueue[head & (cQueueLength - 1)];
-                if (job.load() != nullptr)
-                {
-                    Job* job_ptr = job.exchange(nullptr);
-                    if (job_ptr != nullptr)
-                    {
-                        // And execute it
-                        job_ptr->Execute();
-                        job_ptr->Release();
-                    }
-                }
-                head++;
+                job_ptr->Execute();
+                job_ptr->Release();
             }
         }
     }
 
+    currentPool        = nullptr;
+    currentThreadIndex = -1;
+
     // Call the thread exit function
     mThreadExitFunction(inThreadIndex);
 
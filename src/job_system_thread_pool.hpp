@@ -6,9 +6,11 @@
 
 #include <thread>
 
+#include <Jolt/Core/Mutex.h>
 #include <legs/jolt_pch.hpp>
 
 #include "job_system_with_barrier.hpp"
+#include "work_stealing_queue.hpp"
 
 namespace legs
 {
@@ -82,11 +84,16 @@ class JobSystemThreadPool final : public JobSystemWithBarrier
     /// Entry point for a thread
     void ThreadMain(int inThreadIndex);
 
-    /// Get the head of the thread that has processed the least amount of jobs
-    inline uint GetHead() const;
+    /// Queue of jobs, pushed and popped by one thread and stolen from by the others
+    using JobQueue = WorkStealingQueue<Job>;
 
-    /// Internal helper function to queue a job
-    inline void QueueJobInternal(Job* inJob);
+    /// Find a job for a worker thread: its own queue first, then the injected jobs, then steal from
+    /// the other workers starting at a random one. Returns nullptr when all queues are empty.
+    Job* FindJob(int inThreadIndex, uint32_t& ioRandom);
+
+    /// Internal helper function to queue jobs, on the calling worker's own queue if it is one of
+    /// ours and on the injected queue otherwise
+    inline void QueueJobsInternal(Job** inJobs, uint inNumJobs);
 
     /// Functions to call when initializing or exiting a thread
     InitExitFunction mThreadInitFunction = [](int) {};
@@ -99,16 +106,13 @@ class JobSystemThreadPool final : public JobSystemWithBarrier
     /// Threads running jobs
     JPH::Array<std::thread> mThreads;
 
-    // The job queue
-    static constexpr uint32_t cQueueLength = 1024;
-    static_assert(JPH::IsPowerOf2(cQueueLength)
-    ); // We do bit operations and require queue length to be a power of 2
-    std::atomic<Job*> mQueue[cQueueLength];
+    // Per worker thread queue, only the worker pushes and pops, other workers steal
+    JobQueue* mQueues    = nullptr;
+    uint      mNumQueues = 0;
 
-    // Head and tail of the queue, do this value modulo cQueueLength - 1 to get the element in the
-    // mQueue array
-    std::atomic<uint>* mHeads = nullptr; ///< Per executing thread the head of the current queue
-    alignas(JPH_CACHE_LINE_SIZE) std::atomic<uint> mTail = 0; ///< Tail (write end) of the queue
+    // Jobs queued from threads outside the pool, pushed under the mutex and stolen by the workers
+    JobQueue   mInjectedJobs;
+    JPH::Mutex mInjectedMutex;
 
     // Semaphore used to signal worker threads that there is new work
     JPH::Semaphore mSemaphore;
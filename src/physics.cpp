@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <cstdarg>
 #include <iostream>
@@ -138,7 +139,8 @@ void Physics::Optimize()
 
 void Physics::Update()
 {
-    const unsigned int steps = std::ceil(Time::DeltaTick / m_maxDeltaTime);
+    // Ticks are fixed length, but a low tickrate still needs several substeps.
+    const auto steps = std::max(1, static_cast<int>(std::ceil(Time::DeltaTick / m_maxDeltaTime)));
     m_physicsSystem.Update(Time::DeltaTick, steps, &m_tempAllocator, &m_jobSystem);
 }
 
@@ -168,20 +170,25 @@ void Physics::DestroyBody(JPH::BodyID id)
 }
 
 void Physics::GetBodyTransform(JPH::BodyID id, std::shared_ptr<STransform> trans)
+{
+    GetBodyTransform(id, *trans);
+}
+
+void Physics::GetBodyTransform(JPH::BodyID id, STransform& trans)
 {
     JPH::RVec3 joltPos;
     JPH::Quat  joltRot;
 
     m_physicsSystem.GetBodyInterface().GetPositionAndRotation(id, joltPos, joltRot);
 
-    trans->position.x = joltPos.GetX();
-    trans->position.y = joltPos.GetY();
-    trans->position.z = joltPos.GetZ();
+    trans.position.x = joltPos.GetX();
+    trans.position.y = joltPos.GetY();
+    trans.position.z = joltPos.GetZ();
 
-    trans->rotation.quaternion.x = joltRot.GetX();
-    trans->rotation.quaternion.y = joltRot.GetY();
-    trans->rotation.quaternion.z = joltRot.GetZ();
-    trans->rotation.quaternion.w = joltRot.GetW();
+    trans.rotation.quaternion.x = joltRot.GetX();
+    trans.rotation.quaternion.y = joltRot.GetY();
+    trans.rotation.quaternion.z = joltRot.GetZ();
+    trans.rotation.quaternion.w = joltRot.GetW();
 }
 
 void Physics::SetBodyTransform(JPH::BodyID id, std::shared_ptr<STransform> trans)
@@ -160,12 +160,18 @@ class Physics final : public IPhysics
     void Optimize() override;
     void Update() override;
 
+    JPH::JobSystem* GetJobSystem() override
+    {
+        return &m_jobSystem;
+    }
+
     JPH::BodyID CreateBody(JPH::BodyCreationSettings settings) override;
     void        AddBody(JPH::BodyID id) override;
     void        RemoveBody(JPH::BodyID id) override;
     void        DestroyBody(JPH::BodyID id) override;
 
     void GetBodyTransform(JPH::BodyID id, std::shared_ptr<STransform> trans) override;
+    void GetBodyTransform(JPH::BodyID id, STransform& trans) override;
     void SetBodyTransform(JPH::BodyID id, std::shared_ptr<STransform> trans) override;
 
     void SetBodyPosition(JPH::BodyID id, glm::vec3 pos) override;
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include <legs/components/transform.hpp>
+#include <legs/renderer/buffer.hpp>
+#include <legs/renderer/renderer.hpp>
+
+namespace legs
+{
+struct SMesh
+{
+    RenderPipeline          pipeline = RenderPipeline::INVALID;
+    std::shared_ptr<Buffer> vertexBuffer;
+    std::shared_ptr<Buffer> indexBuffer;
+    // Arena mesh, drawn instead of the buffers when set.
+    std::shared_ptr<SMeshAllocation> mesh;
+    // Mesh space bounds for frustum culling, never culled without.
+    std::optional<SBoundingSphere> bounds;
+
+    // Transform published with the previous snapshot, for interpolation.
+    STransform snapshotTransform;
+    bool       hasSnapshot = false;
+};
+} // namespace legs
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <legs/jolt_pch.hpp>
+
+namespace legs
+{
+// Jolt body driving the entity's STransform,
+// created and added to the physics system by the caller.
+struct SPhysicsBody
+{
+    JPH::BodyID id;
+};
+} // namespace legs
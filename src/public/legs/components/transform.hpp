@@ -1,7 +1,10 @@
 #pragma once
 
+#include <glm/common.hpp>
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/quaternion_common.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/vec3.hpp>
 
 #include <legs/components/rotation.hpp>
@@ -15,16 +18,24 @@ struct STransform
     glm::vec3 velocity;
     glm::vec3 angularVelocity;
 
-    glm::mat4x4 GetModelMatrix()
+    glm::mat4x4 GetModelMatrix() const
     {
         auto model = glm::identity<glm::mat4x4>();
         model      = glm::translate(model, position);
-        model      = glm::rotate(model, glm::radians(rotation.euler.x), glm::vec3 {1, 0, 0});
-        model      = glm::rotate(model, glm::radians(rotation.euler.y), glm::vec3 {0, 1, 0});
-        model      = glm::rotate(model, glm::radians(rotation.euler.z), glm::vec3 {0, 0, 1});
+        model      = model * glm::mat4_cast(rotation.quaternion);
         return model;
     }
 
+    // Blend position and rotation between two ticks for rendering.
+    static STransform Interpolate(const STransform& from, const STransform& to, float alpha)
+    {
+        STransform result = to;
+        result.position   = glm::mix(from.position, to.position, alpha);
+        result.rotation.quaternion =
+            glm::slerp(from.rotation.quaternion, to.rotation.quaternion, alpha);
+        return result;
+    }
+
     glm::vec3 Forward()
     {
         return rotation.quaternion * glm::vec3(0.0f, 1.0f, 0.0f);
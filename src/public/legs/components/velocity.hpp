@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+namespace legs
+{
+// Integrated into STransform every tick for entities without a physics body.
+struct SVelocity
+{
+    glm::vec3 linear;
+    glm::vec3 angular;
+};
+} // namespace legs
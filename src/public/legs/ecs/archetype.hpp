@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <legs/ecs/entity_id.hpp>
+
+namespace legs
+{
+using ComponentId   = uint32_t;
+using ComponentMask = uint64_t;
+
+static constexpr size_t MaxComponents = 64;
+
+inline ComponentId NextComponentId()
+{
+    static std::atomic<ComponentId> next = 0;
+
+    const auto id = next++;
+    if (id >= MaxComponents)
+    {
+        throw std::runtime_error("Too many component types");
+    }
+    return id;
+}
+
+// Stable per-type id, assigned the first time a component type is used.
+template<typename T>
+ComponentId GetComponentId()
+{
+    static const ComponentId id = NextComponentId();
+    return id;
+}
+
+template<typename T>
+ComponentMask GetComponentBit()
+{
+    return ComponentMask {1} << GetComponentId<std::remove_cvref_t<T>>();
+}
+
+template<typename... Ts>
+ComponentMask GetComponentMask()
+{
+    return (ComponentMask {0} | ... | GetComponentBit<Ts>());
+}
+
+// Type-erased storage for one component type within an archetype.
+// Virtual calls only happen on structural changes, never while iterating.
+class IColumn
+{
+  public:
+    IColumn()          = default;
+    virtual ~IColumn() = default;
+
+    IColumn(const IColumn&)            = delete;
+    IColumn(IColumn&&)                 = delete;
+    IColumn& operator=(const IColumn&) = delete;
+    IColumn& operator=(IColumn&&)      = delete;
+
+    virtual std::unique_ptr<IColumn> CreateEmpty() const               = 0;
+    virtual void                     MoveRowTo(size_t row, IColumn& to) = 0;
+    virtual void                     SwapRemove(size_t row)             = 0;
+    virtual size_t                   Size() const                       = 0;
+};
+
+template<typename T>
+class Column : public IColumn
+{
+  public:
+    std::unique_ptr<IColumn> CreateEmpty() const override
+    {
+        return std::make_unique<Column<T>>();
+    }
+
+    void MoveRowTo(size_t row, IColumn& to) override
+    {
+        static_cast<Column<T>&>(to).Data.push_back(std::move(Data[row]));
+    }
+
+    void SwapRemove(size_t row) override
+    {
+        if (row != Data.size() - 1)
+        {
+            Data[row] = std::move(Data.back());
+        }
+        Data.pop_back();
+    }
+
+    size_t Size() const override
+    {
+        return Data.size();
+    }
+
+    std::vector<T> Data;
+};
+
+// All entities with exactly the same set of components,
+// each component type stored in its own contiguous array.
+class Archetype
+{
+  public:
+    Archetype() = delete;
+    Archetype(ComponentMask mask) : m_mask(mask)
+    {
+    }
+
+    Archetype(const Archetype&)            = delete;
+    Archetype(Archetype&&)                 = delete;
+    Archetype& operator=(const Archetype&) = delete;
+    Archetype& operator=(Archetype&&)      = delete;
+
+    template<typename T>
+    void AddColumn()
+    {
+        m_columns[GetComponentId<T>()] = std::make_unique<Column<T>>();
+    }
+
+    // Create empty columns for the components of another archetype included in our mask.
+    void CopyLayout(const Archetype& other)
+    {
+        ForEachComponent(
+            m_mask & other.m_mask,
+            [&](ComponentId id) { m_columns[id] = other.m_columns[id]->CreateEmpty(); }
+        );
+    }
+
+    ComponentMask GetMask() const
+    {
+        return m_mask;
+    }
+
+    bool HasAll(ComponentMask mask) const
+    {
+        return (m_mask & mask) == mask;
+    }
+
+    bool HasAny(ComponentMask mask) const
+    {
+        return (m_mask & mask) != 0;
+    }
+
+    size_t Size() const
+    {
+        return m_entities.size();
+    }
+
+    const std::vector<EntityId>& GetEntities() const
+    {
+        return m_entities;
+    }
+
+    template<typename T>
+    std::vector<T>& GetColumn()
+    {
+        auto& column = m_columns[GetComponentId<T>()];
+        if (column == nullptr)
+        {
+            throw std::runtime_error("Component not in archetype");
+        }
+        return static_cast<Column<T>&>(*column).Data;
+    }
+
+    // Append an entity, the caller pushes its components to every column.
+    size_t PushEntity(EntityId entity)
+    {
+        m_entities.push_back(entity);
+        return m_entities.size() - 1;
+    }
+
+    // Move a row to another archetype, dropping components the other one doesn't have.
+    // Returns the entity that was swapped into the row, InvalidEntity if none.
+    EntityId MoveRowTo(size_t row, Archetype& to)
+    {
+        ForEachComponent(
+            m_mask,
+            [&](ComponentId id)
+            {
+                if (to.m_columns[id] != nullptr)
+                {
+                    m_columns[id]->MoveRowTo(row, *to.m_columns[id]);
+                }
+            }
+        );
+        to.m_entities.push_back(m_entities[row]);
+        return RemoveRow(row);
+    }
+
+    // Swap-and-pop a row.
+    // Returns the entity that was swapped into the row, InvalidEntity if none.
+    EntityId RemoveRow(size_t row)
+    {
+        ForEachComponent(m_mask, [&](ComponentId id) { m_columns[id]->SwapRemove(row); });
+
+        const auto last = m_entities.size() - 1;
+        if (row == last)
+        {
+            m_entities.pop_back();
+            return InvalidEntity;
+        }
+
+        m_entities[row] = m_entities[last];
+        m_entities.pop_back();
+        return m_entities[row];
+    }
+
+  private:
+    template<typename Fn>
+    static void ForEachComponent(ComponentMask mask, Fn&& fn)
+    {
+        while (mask != 0)
+        {
+            const auto id = static_cast<ComponentId>(std::countr_zero(mask));
+            fn(id);
+            mask &= mask - 1;
+        }
+    }
+
+    ComponentMask                                       m_mask;
+    std::vector<EntityId>                               m_entities;
+    std::array<std::unique_ptr<IColumn>, MaxComponents> m_columns;
+};
+} // namespace legs
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <legs/ecs/registry.hpp>
+#include <legs/entity/entity.hpp>
+
+namespace legs
+{
+// Structural changes recorded on one thread and applied later by the world
+// in a single pass at a sync point, so nothing iterating entities sees them mid-tick.
+class CommandBuffer
+{
+  public:
+    CommandBuffer() = delete;
+    CommandBuffer(Registry& registry) : m_registry(registry)
+    {
+    }
+
+    ~CommandBuffer() = default;
+
+    CommandBuffer(const CommandBuffer&)            = delete;
+    CommandBuffer(CommandBuffer&&)                 = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(CommandBuffer&&)      = delete;
+
+    // The id is valid right away for recording further commands,
+    // the entity becomes alive once the buffer is applied.
+    template<typename... Ts>
+    EntityId Spawn(Ts&&... components)
+    {
+        const auto id = m_registry.ReserveId();
+
+        std::scoped_lock bufferLock {m_mutex};
+        m_pending.spawns.emplace_back(
+            [id, ... values = std::forward<Ts>(components)](Registry& registry) mutable
+            { registry.Emplace(id, std::move(values)...); }
+        );
+        return id;
+    }
+
+    void Despawn(EntityId entity)
+    {
+        std::scoped_lock bufferLock {m_mutex};
+        m_pending.despawns.push_back(entity);
+    }
+
+    template<typename T>
+    void Add(EntityId entity, T component = {})
+    {
+        std::scoped_lock bufferLock {m_mutex};
+        m_pending.changes.emplace_back(
+            [entity, value = std::move(component)](Registry& registry) mutable
+            {
+                if (registry.IsAlive(entity))
+                {
+                    registry.Add<T>(entity, std::move(value));
+                }
+            }
+        );
+    }
+
+    template<typename T>
+    void Remove(EntityId entity)
+    {
+        std::scoped_lock bufferLock {m_mutex};
+        m_pending.changes.emplace_back(
+            [entity](Registry& registry)
+            {
+                if (registry.IsAlive(entity))
+                {
+                    registry.Remove<T>(entity);
+                }
+            }
+        );
+    }
+
+    void AddEntity(std::shared_ptr<Entity> entity)
+    {
+        std::scoped_lock bufferLock {m_mutex};
+        m_pending.addedEntities.push_back(std::move(entity));
+    }
+
+    void RemoveEntity(std::shared_ptr<Entity> entity)
+    {
+        std::scoped_lock bufferLock {m_mutex};
+        m_pending.removedEntities.push_back(std::move(entity));
+    }
+
+    struct SCommands
+    {
+        std::vector<std::function<void(Registry&)>> spawns;
+        std::vector<std::function<void(Registry&)>> changes;
+        std::vector<EntityId>                       despawns;
+        std::vector<std::shared_ptr<Entity>>        addedEntities;
+        std::vector<std::shared_ptr<Entity>>        removedEntities;
+
+        bool Empty() const
+        {
+            return spawns.empty() && changes.empty() && despawns.empty() && addedEntities.empty()
+                   && removedEntities.empty();
+        }
+
+        void Clear()
+        {
+            spawns.clear();
+            changes.clear();
+            despawns.clear();
+            addedEntities.clear();
+            removedEntities.clear();
+        }
+    };
+
+    // Swap out everything recorded so far, keeping the vectors' capacity around.
+    void Take(SCommands& commands)
+    {
+        commands.Clear();
+
+        std::scoped_lock bufferLock {m_mutex};
+        std::swap(commands, m_pending);
+    }
+
+  private:
+    Registry& m_registry;
+
+    // Only contended while the world is applying this buffer.
+    std::mutex m_mutex;
+    SCommands  m_pending;
+};
+} // namespace legs
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace legs
+{
+// Low 32 bits index into the registry, high 32 bits are the generation
+// of that slot, so stale ids of destroyed entities never alias new ones.
+using EntityId = uint64_t;
+
+static constexpr EntityId InvalidEntity = UINT64_MAX;
+
+constexpr EntityId MakeEntityId(uint32_t index, uint32_t generation)
+{
+    return (static_cast<EntityId>(generation) << 32) | index;
+}
+
+constexpr uint32_t GetEntityIndex(EntityId entity)
+{
+    return static_cast<uint32_t>(entity);
+}
+
+constexpr uint32_t GetEntityGeneration(EntityId entity)
+{
+    return static_cast<uint32_t>(entity >> 32);
+}
+} // namespace legs
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <legs/ecs/archetype.hpp>
+
+namespace legs
+{
+// Components an Each query skips entities for.
+template<typename... Ts>
+struct Exclude
+{
+    static ComponentMask Mask()
+    {
+        return GetComponentMask<Ts...>();
+    }
+};
+
+// Archetype based component store.
+// Entities with the same set of components share an archetype,
+// queries walk the matching archetypes' contiguous component arrays.
+// Structural changes (create, destroy, add, remove) invalidate
+// component references and must not happen inside Each.
+// Everything but ReserveId is for the owning thread only,
+// other threads record changes into a CommandBuffer instead.
+class Registry
+{
+  public:
+    Registry()
+    {
+        // Entities created without components.
+        CreateArchetype(0);
+    }
+
+    ~Registry() = default;
+
+    Registry(const Registry&)            = delete;
+    Registry(Registry&&)                 = delete;
+    Registry& operator=(const Registry&) = delete;
+    Registry& operator=(Registry&&)      = delete;
+
+    template<typename... Ts>
+    EntityId Create(Ts&&... components)
+    {
+        const auto id = ReserveId();
+        Emplace(id, std::forward<Ts>(components)...);
+        return id;
+    }
+
+    // Get an id for an entity that will be created later with Emplace, thread-safe.
+    EntityId ReserveId()
+    {
+        std::scoped_lock idLock {m_idMutex};
+
+        if (!m_freeIds.empty())
+        {
+            const auto id = m_freeIds.back();
+            m_freeIds.pop_back();
+            return id;
+        }
+
+        return MakeEntityId(m_nextIndex++, 0);
+    }
+
+    // Create an entity with an id from ReserveId.
+    template<typename... Ts>
+    void Emplace(EntityId id, Ts&&... components)
+    {
+        const ComponentMask mask = GetComponentMask<Ts...>();
+        Archetype*          arch = FindArchetype(mask);
+        if (arch == nullptr)
+        {
+            arch = &CreateArchetype(mask);
+            (arch->AddColumn<std::remove_cvref_t<Ts>>(), ...);
+        }
+
+        const auto index = GetEntityIndex(id);
+        if (index >= m_records.size())
+        {
+            m_records.resize(index + 1);
+        }
+
+        const auto row = arch->PushEntity(id);
+        (arch->GetColumn<std::remove_cvref_t<Ts>>().push_back(std::forward<Ts>(components)), ...);
+
+        auto& record      = m_records[index];
+        record.archetype  = arch;
+        record.row        = row;
+        record.generation = GetEntityGeneration(id);
+        m_count++;
+    }
+
+    void Destroy(EntityId entity)
+    {
+        auto& record = GetRecord(entity);
+
+        const auto swapped = record.archetype->RemoveRow(record.row);
+        if (swapped != InvalidEntity)
+        {
+            m_records[GetEntityIndex(swapped)].row = record.row;
+        }
+
+        // Bumping the generation invalidates every copy of the old id.
+        record.archetype = nullptr;
+        record.row       = 0;
+        record.generation++;
+        m_count--;
+
+        std::scoped_lock idLock {m_idMutex};
+        m_freeIds.push_back(MakeEntityId(GetEntityIndex(entity), record.generation));
+    }
+
+    bool IsAlive(EntityId entity) const
+    {
+        const auto index = GetEntityIndex(entity);
+        return index < m_records.size() && m_records[index].archetype != nullptr
+               && m_records[index].generation == GetEntityGeneration(entity);
+    }
+
+    // Preallocate for a burst of spawns.
+    void Reserve(size_t count)
+    {
+        m_records.reserve(count);
+    }
+
+    template<typename T>
+    T& Add(EntityId entity, T component = {})
+    {
+        auto& record = GetRecord(entity);
+        auto* from   = record.archetype;
+        if (from->HasAll(GetComponentBit<T>()))
+        {
+            auto& existing = from->GetColumn<T>()[record.row];
+            existing       = std::move(component);
+            return existing;
+        }
+
+        const ComponentMask mask = from->GetMask() | GetComponentBit<T>();
+        Archetype*          to   = FindArchetype(mask);
+        if (to == nullptr)
+        {
+            to = &CreateArchetype(mask);
+            to->CopyLayout(*from);
+            to->AddColumn<T>();
+        }
+
+        MoveEntity(entity, *to);
+
+        auto& column = to->GetColumn<T>();
+        column.push_back(std::move(component));
+        return column.back();
+    }
+
+    template<typename T>
+    void Remove(EntityId entity)
+    {
+        auto& record = GetRecord(entity);
+        auto* from   = record.archetype;
+        if (!from->HasAll(GetComponentBit<T>()))
+        {
+            return;
+        }
+
+        const ComponentMask mask = from->GetMask() & ~GetComponentBit<T>();
+        Archetype*          to   = FindArchetype(mask);
+        if (to == nullptr)
+        {
+            to = &CreateArchetype(mask);
+            to->CopyLayout(*from);
+        }
+
+        MoveEntity(entity, *to);
+    }
+
+    template<typename T>
+    bool Has(EntityId entity) const
+    {
+        return IsAlive(entity)
+               && m_records[GetEntityIndex(entity)].archetype->HasAll(GetComponentBit<T>());
+    }
+
+    template<typename T>
+    T& Get(EntityId entity)
+    {
+        auto& record = GetRecord(entity);
+        return record.archetype->GetColumn<T>()[record.row];
+    }
+
+    template<typename T>
+    T* TryGet(EntityId entity)
+    {
+        if (!Has<T>(entity))
+        {
+            return nullptr;
+        }
+        return &Get<T>(entity);
+    }
+
+    // Call fn(Ts&...) or fn(EntityId, Ts&...) for every entity with all of Ts.
+    template<typename... Ts, typename Fn>
+    void Each(Fn&& fn)
+    {
+        Each<Ts...>(Exclude<> {}, std::forward<Fn>(fn));
+    }
+
+    // Same as above, skipping entities with any of Xs.
+    template<typename... Ts, typename... Xs, typename Fn>
+    void Each(Exclude<Xs...>, Fn&& fn)
+    {
+        const auto include = GetComponentMask<Ts...>();
+        const auto exclude = Exclude<Xs...>::Mask();
+
+        for (auto& arch : m_archetypes)
+        {
+            if (arch->Size() == 0 || !arch->HasAll(include) || arch->HasAny(exclude))
+            {
+                continue;
+            }
+
+            const auto& entities = arch->GetEntities();
+            auto columns = std::make_tuple(arch->GetColumn<std::remove_cv_t<Ts>>().data()...);
+
+            std::apply(
+                [&](auto*... data)
+                {
+                    for (size_t i = 0; i < entities.size(); i++)
+                    {
+                        if constexpr (std::is_invocable_v<Fn, EntityId, Ts&...>)
+                        {
+                            fn(entities[i], data[i]...);
+                        }
+                        else
+                        {
+                            fn(data[i]...);
+                        }
+                    }
+                },
+                columns
+            );
+        }
+    }
+
+    size_t Count() const
+    {
+        return m_count;
+    }
+
+    size_t ArchetypeCount() const
+    {
+        return m_archetypes.size();
+    }
+
+  private:
+    struct SRecord
+    {
+        Archetype* archetype  = nullptr;
+        size_t     row        = 0;
+        uint32_t   generation = 0;
+    };
+
+    SRecord& GetRecord(EntityId entity)
+    {
+        if (!IsAlive(entity))
+        {
+            throw std::runtime_error("Tried to access a destroyed entity");
+        }
+        return m_records[GetEntityIndex(entity)];
+    }
+
+    Archetype* FindArchetype(ComponentMask mask)
+    {
+        auto it = m_archetypeLookup.find(mask);
+        return it != m_archetypeLookup.end() ? it->second : nullptr;
+    }
+
+    Archetype& CreateArchetype(ComponentMask mask)
+    {
+        auto& arch              = m_archetypes.emplace_back(std::make_unique<Archetype>(mask));
+        m_archetypeLookup[mask] = arch.get();
+        return *arch;
+    }
+
+    void MoveEntity(EntityId entity, Archetype& to)
+    {
+        auto& record = m_records[GetEntityIndex(entity)];
+
+        const auto swapped = record.archetype->MoveRowTo(record.row, to);
+        if (swapped != InvalidEntity)
+        {
+            m_records[GetEntityIndex(swapped)].row = record.row;
+        }
+
+        record.archetype = &to;
+        record.row       = to.Size() - 1;
+    }
+
+    std::vector<std::unique_ptr<Archetype>>       m_archetypes;
+    std::unordered_map<ComponentMask, Archetype*> m_archetypeLookup;
+
+    // Indexed by GetEntityIndex, slots of destroyed entities are reused.
+    std::vector<SRecord> m_records;
+    size_t               m_count = 0;
+
+    // Reservations can come from any thread,
+    // so they never touch m_records.
+    std::mutex            m_idMutex;
+    std::vector<EntityId> m_freeIds;
+    uint32_t              m_nextIndex = 0;
+};
+} // namespace legs
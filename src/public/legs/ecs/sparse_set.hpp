@@ -0,0 +1,115 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <legs/ecs/entity_id.hpp>
+
+namespace legs
+{
+// Values keyed by EntityId with O(1) insert, lookup and swap-and-pop removal.
+// Values are packed densely, iteration order changes on removal.
+template<typename T>
+class SparseSet
+{
+  public:
+    void Insert(EntityId entity, T value)
+    {
+        const auto index = GetEntityIndex(entity);
+        if (index >= m_sparse.size())
+        {
+            m_sparse.resize(index + 1, Empty);
+        }
+
+        if (m_sparse[index] != Empty)
+        {
+            m_dense[m_sparse[index]]    = std::move(value);
+            m_denseIds[m_sparse[index]] = entity;
+            return;
+        }
+
+        m_sparse[index] = static_cast<uint32_t>(m_dense.size());
+        m_dense.push_back(std::move(value));
+        m_denseIds.push_back(entity);
+    }
+
+    bool Erase(EntityId entity)
+    {
+        if (!Contains(entity))
+        {
+            return false;
+        }
+
+        const auto index = GetEntityIndex(entity);
+        const auto slot  = m_sparse[index];
+        const auto last  = static_cast<uint32_t>(m_dense.size() - 1);
+        if (slot != last)
+        {
+            m_dense[slot]    = std::move(m_dense[last]);
+            m_denseIds[slot] = m_denseIds[last];
+
+            m_sparse[GetEntityIndex(m_denseIds[slot])] = slot;
+        }
+
+        m_dense.pop_back();
+        m_denseIds.pop_back();
+        m_sparse[index] = Empty;
+        return true;
+    }
+
+    bool Contains(EntityId entity) const
+    {
+        const auto index = GetEntityIndex(entity);
+        return index < m_sparse.size() && m_sparse[index] != Empty
+               && m_denseIds[m_sparse[index]] == entity;
+    }
+
+    T* Find(EntityId entity)
+    {
+        if (!Contains(entity))
+        {
+            return nullptr;
+        }
+        return &m_dense[m_sparse[GetEntityIndex(entity)]];
+    }
+
+    void Clear()
+    {
+        m_sparse.clear();
+        m_dense.clear();
+        m_denseIds.clear();
+    }
+
+    size_t Size() const
+    {
+        return m_dense.size();
+    }
+
+    std::vector<T>& GetValues()
+    {
+        return m_dense;
+    }
+
+    const std::vector<EntityId>& GetIds() const
+    {
+        return m_denseIds;
+    }
+
+    auto begin()
+    {
+        return m_dense.begin();
+    }
+
+    auto end()
+    {
+        return m_dense.end();
+    }
+
+  private:
+    static constexpr uint32_t Empty = UINT32_MAX;
+
+    std::vector<uint32_t> m_sparse;
+    std::vector<T>        m_dense;
+    std::vector<EntityId> m_denseIds;
+};
+} // namespace legs
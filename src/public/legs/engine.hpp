@@ -1,31 +1,117 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <semaphore>
 #include <stop_token>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <glm/gtc/quaternion.hpp>
 #include <glm/vec3.hpp>
 
 #include <legs/world/world.hpp>
 
+#include <legs/frame_queue.hpp>
 #include <legs/isystem.hpp>
 #include <legs/renderer/renderer.hpp>
+#include <legs/system_scheduler.hpp>
 #include <legs/ui/ui.hpp>
 #include <legs/window/input.hpp>
 #include <legs/window/window.hpp>
 
 namespace legs
 {
+struct EngineSettings
+{
+    // Skip window, renderer and UI creation,
+    // only ticks run (on the main thread).
+    bool headless = false;
+
+    // Fixed simulation rate, frames interpolate between ticks.
+    unsigned int tickRate = 60;
+
+    // Simulation time that can pile up before it is dropped
+    // instead of being caught up with extra ticks.
+    unsigned int maxCatchUpTicks = 5;
+
+    // Headless only: tick as fast as possible
+    // instead of at tickRate.
+    bool uncappedTickRate = false;
+
+    // Headless only: stop after this many ticks, 0 to run forever.
+    uint64_t maxTicks = 0;
+
+    // Tick thread-safe entities in parallel on the job system.
+    bool parallelEntityTick = false;
+
+    // How many frames (and ticks) the main thread can queue
+    // ahead of the render (and tick) thread.
+    unsigned int pipelineDepth = 2;
+
+    // Render into offscreen images instead of a window, without input or UI.
+    // For benchmarks and image tests where there is no display, e.g. lavapipe in CI.
+    bool         offscreen       = false;
+    unsigned int offscreenWidth  = 1280;
+    unsigned int offscreenHeight = 720;
+
+    // Offscreen only: stop after this many frames, 0 to run forever.
+    uint64_t maxFrames = 0;
+
+    // Offscreen only: read every readbackInterval'th frame back, 0 for none.
+    // Frames go to onReadback if set, otherwise to frame_<number>.ppm in readbackDirectory.
+    unsigned int readbackInterval  = 0;
+    std::string  readbackDirectory = ".";
+
+    std::function<void(uint64_t frame, const SReadbackImage& image)> onReadback;
+};
+
+// Everything the render thread needs from the main thread for one frame.
+struct FrameContext
+{
+    uint64_t          frame;
+    FrameBufferObject frameUbo;
+    ViewBufferObject  view;
+    // Bumped only when the view changed, the renderer skips rewriting it otherwise.
+    uint64_t viewRevision;
+    // Simulation time to render at, between the last two ticks.
+    double time;
+    // Window and UI changes, applied on the render thread
+    // since it is still drawing earlier frames.
+    bool                                                 resize;
+    std::array<bool, static_cast<size_t>(UIWindow::MAX)> toggleWindow;
+    std::vector<SDL_Event>                               uiEvents;
+};
+
+// Everything the tick thread needs from the main thread for one tick.
+struct TickContext
+{
+    uint64_t    tick;
+    double      delta;
+    WindowInput input;
+};
+
 class Engine
 {
   public:
-    Engine();
+    Engine(EngineSettings settings = {});
     ~Engine();
 
     int Run();
 
+    void Stop()
+    {
+        m_stopRequested = true;
+    }
+
+    bool IsHeadless() const
+    {
+        return m_settings.headless;
+    }
+
     std::shared_ptr<Window> GetWindow() const
     {
         return m_window;
@@ -33,7 +119,8 @@ class Engine
 
     void AddSystem(std::shared_ptr<ISystem> system)
     {
-        m_systems.push_back(system);
+        m_frameSystems.Add(system);
+        m_tickSystems.Add(system);
     }
 
     std::shared_ptr<Renderer> GetRenderer()
@@ -53,7 +140,8 @@ class Engine
 
     void SetCamera(std::shared_ptr<Camera> camera)
     {
-        m_camera = camera;
+        m_camera    = camera;
+        m_viewDirty = true;
     }
 
     WindowInput GetFrameInput()
@@ -67,14 +155,29 @@ class Engine
     }
 
   private:
+    int  RunHeadless();
+    void UpdateTickAccumulator();
+
     void Frame();
     bool Tick();
+    void RunTick();
+
+    void UpdateInput(std::vector<SDL_Event>& uiEvents);
+
+    // Render thread: resize and UI changes the main thread queued with the frame.
+    void ApplyFrameChanges(const FrameContext& context);
+
+    // Render thread, or wherever the renderer goes idle for the last frames.
+    void OnReadback(uint64_t frame, const SReadbackImage& image);
 
-    void UpdateInput();
+    JPH::JobSystem* GetJobSystem();
 
     void TickThread(const std::stop_token token);
     void RenderThread(const std::stop_token token);
 
+    EngineSettings    m_settings;
+    std::atomic<bool> m_stopRequested = false;
+
     std::shared_ptr<InputSettings> m_inputSettings;
     std::shared_ptr<Window>        m_window;
     std::shared_ptr<Camera>        m_camera;
@@ -85,15 +188,30 @@ class Engine
     WindowInput m_frameInput;
     WindowInput m_tickInput;
 
+    // Input aggregated on the main thread since the last queued tick.
+    WindowInput m_pendingTickInput;
+
     std::jthread m_tickThread;
     std::jthread m_renderThread;
 
-    std::binary_semaphore m_mainTickSemaphore {0};
-    std::binary_semaphore m_threadTickSemaphore {0};
+    FrameQueue<FrameContext> m_frameQueue;
+    FrameQueue<TickContext>  m_tickQueue;
+
+    uint64_t m_frameCount = 0;
+    uint64_t m_tickCount  = 0;
+
+    // View matrices cached between frames, recomputed when the camera changes.
+    ViewBufferObject m_view {};
+    uint64_t         m_viewCameraVersion = 0;
+    uint64_t         m_viewRevision      = 0;
+    bool             m_viewDirty         = true;
 
-    std::binary_semaphore m_mainFrameSemaphore {0};
-    std::binary_semaphore m_threadFrameSemaphore {0};
+    // Wall time not yet consumed by fixed ticks.
+    double m_tickAccumulator  = 0.0;
+    double m_previousTickTime = 0.0;
+    double m_simulationTime   = 0.0;
 
-    std::vector<std::shared_ptr<ISystem>> m_systems;
+    SystemScheduler m_frameSystems {SystemPhase::FRAME};
+    SystemScheduler m_tickSystems {SystemPhase::TICK};
 };
 } // namespace legs
@@ -34,13 +34,21 @@ class Camera : public Entity
     void UpdateMatrices()
     {
         Transform->rotation.UpdateQuaternion();
-        view = glm::lookAt(
+        auto newView = glm::lookAt(
             Transform->position,
             Transform->position + Transform->Forward(),
             glm::vec3(0.0f, 0.0f, 1.0f)
         );
-        proj = glm::perspective(glm::radians(fov), aspect, near, far);
-        proj[1][1] *= -1; // OpenGL Y flip
+        auto newProj = glm::perspective(glm::radians(fov), aspect, near, far);
+        newProj[1][1] *= -1; // OpenGL Y flip
+
+        // Still cameras keep their version, so the view isn't recomputed downstream.
+        if (newView != view || newProj != proj)
+        {
+            view = newView;
+            proj = newProj;
+            m_version++;
+        }
     }
 
     void UpdateViewport(int width, int height)
@@ -50,6 +58,13 @@ class Camera : public Entity
         viewport.y = static_cast<float>(height);
         viewport.z = CAM_NEAR;
         viewport.w = CAM_FAR;
+        m_version++;
+    }
+
+    // Bumped whenever the matrices or viewport change.
+    uint64_t GetVersion() const
+    {
+        return m_version;
     }
 
     float     fov;
@@ -57,8 +72,11 @@ class Camera : public Entity
     float     near;
     float     far;
     glm::vec4 viewport;
-    glm::mat4 view;
-    glm::mat4 proj;
+    glm::mat4 view {};
+    glm::mat4 proj {};
+
+  private:
+    uint64_t m_version = 0;
 };
 
 class NoclipCamera : public Camera
@@ -4,6 +4,7 @@
 #include <string>
 
 #include <legs/components/transform.hpp>
+#include <legs/ecs/entity_id.hpp>
 
 namespace legs
 {
@@ -23,6 +24,14 @@ class Entity
     virtual void OnFrame() {};
     virtual void OnTick() {};
 
+    // Opt in to running OnTick on the job system alongside other entities.
+    // OnTick must then only touch this entity's own state,
+    // world changes go through World::GetCommands().
+    virtual bool IsThreadSafe() const
+    {
+        return false;
+    }
+
     virtual void SetPosition(glm::vec3 pos)
     {
         Transform->position = pos;
@@ -68,8 +77,19 @@ class Entity
         return Transform->angularVelocity;
     }
 
+    // Registry id while spawned in a world, InvalidEntity otherwise.
+    EntityId GetId() const
+    {
+        return m_id;
+    }
+
   protected:
     std::string                 Name;
     std::shared_ptr<STransform> Transform;
+
+  private:
+    friend class World;
+
+    EntityId m_id = InvalidEntity;
 };
 }; // namespace legs
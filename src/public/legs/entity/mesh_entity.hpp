@@ -1,11 +1,13 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 
 #include <legs/entity/entity.hpp>
 #include <legs/renderer/buffer.hpp>
 #include <legs/renderer/renderer.hpp>
+#include <legs/world/world_snapshot.hpp>
 
 namespace legs
 {
@@ -43,15 +45,27 @@ class MeshEntity : public Entity
         Entity::OnTick();
     }
 
+    // Without bounds the entity is drawn even when off screen.
     virtual void SetBuffers(
-        std::shared_ptr<Buffer> vertexBuffer,
-        std::shared_ptr<Buffer> indexBuffer
+        std::shared_ptr<Buffer>        vertexBuffer,
+        std::shared_ptr<Buffer>        indexBuffer,
+        std::optional<SBoundingSphere> bounds = std::nullopt
     )
     {
         m_vertexBuffer = vertexBuffer;
         m_indexBuffer  = indexBuffer;
+        m_bounds       = bounds;
     }
 
+    // Draw a mesh from the renderer's arena instead of separate buffers.
+    virtual void SetMesh(std::shared_ptr<SMeshAllocation> mesh)
+    {
+        m_mesh   = mesh;
+        m_bounds = mesh != nullptr ? std::optional(mesh->bounds) : std::nullopt;
+    }
+
+    // Immediate draw without a model matrix, for things like the sky.
+    // Entities in the world are drawn from their snapshot instead.
     virtual void Render(std::shared_ptr<Renderer> renderer)
     {
         if (m_pipeline == RenderPipeline::INVALID)
@@ -59,9 +73,36 @@ class MeshEntity : public Entity
             return;
         }
 
-        // TODO: Transform matrices
         renderer->BindPipeline(m_pipeline);
-        renderer->DrawWithBuffers(m_vertexBuffer, m_indexBuffer);
+        if (m_mesh != nullptr)
+        {
+            renderer->DrawMesh(m_mesh);
+        }
+        else
+        {
+            renderer->DrawWithBuffers(m_vertexBuffer, m_indexBuffer);
+        }
+    }
+
+    // Copy renderable state for the render thread, called on the tick thread.
+    virtual void Snapshot(SRenderObject& object)
+    {
+        // Nothing to blend from on the first snapshot.
+        if (!m_hasSnapshot)
+        {
+            m_snapshotTransform = *Transform;
+            m_hasSnapshot       = true;
+        }
+
+        object.previousTransform = m_snapshotTransform;
+        object.transform         = *Transform;
+        m_snapshotTransform      = *Transform;
+
+        object.pipeline     = m_pipeline;
+        object.vertexBuffer = m_vertexBuffer;
+        object.indexBuffer  = m_indexBuffer;
+        object.mesh         = m_mesh;
+        object.bounds       = m_bounds;
     }
 
     virtual void SetPipeline(RenderPipeline pipeline)
@@ -70,8 +111,14 @@ class MeshEntity : public Entity
     }
 
   protected:
-    RenderPipeline          m_pipeline;
-    std::shared_ptr<Buffer> m_vertexBuffer;
-    std::shared_ptr<Buffer> m_indexBuffer;
+    RenderPipeline                   m_pipeline;
+    std::shared_ptr<Buffer>          m_vertexBuffer;
+    std::shared_ptr<Buffer>          m_indexBuffer;
+    std::shared_ptr<SMeshAllocation> m_mesh;
+    std::optional<SBoundingSphere>   m_bounds;
+
+  private:
+    STransform m_snapshotTransform;
+    bool       m_hasSnapshot = false;
 };
 }; // namespace legs
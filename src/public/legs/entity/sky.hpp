@@ -48,8 +48,8 @@ class Sky : public MeshEntity
 
     void Render(std::shared_ptr<Renderer> renderer) override
     {
-        renderer->GetUBO()->sunDir   = SunDirection;
-        renderer->GetUBO()->sunColor = SunColor;
+        renderer->GetFrameUBO()->sunDir   = SunDirection;
+        renderer->GetFrameUBO()->sunColor = SunColor;
         MeshEntity::Render(renderer);
     }
 
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <type_traits>
+#include <utility>
 
 #include <legs/engine.hpp>
 #include <legs/log.hpp>
@@ -29,11 +32,78 @@ static bool HasLaunchArg(const char* name, const char* value, int argc, char** a
     return false;
 }
 
-static int LEGS_Init(int /*argc*/, char** /*argv*/)
+static const char* GetLaunchArg(const char* name, int argc, char** argv)
+{
+    for (int i = 0; i < argc - 1; i++)
+    {
+        if (std::strcmp(name, argv[i]) == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+// Parse a whole decimal number into value, which is kept with a warning
+// when the argument is not a number or out of [minimum, max of T].
+template<typename T>
+static void GetLaunchArgNumber(
+    const char*             name,
+    T&                      value,
+    std::type_identity_t<T> minimum,
+    int                     argc,
+    char**                  argv
+)
+{
+    auto arg = GetLaunchArg(name, argc, argv);
+    if (arg == nullptr)
+    {
+        return;
+    }
+
+    char* end    = nullptr;
+    auto  parsed = std::strtoull(arg, &end, 10);
+    if (end == arg || *end != '\0' || arg[0] == '-' || !std::in_range<T>(parsed)
+        || parsed < minimum)
+    {
+        LOG_WARN("Invalid {} '{}', using {}", name, arg, value);
+        return;
+    }
+    value = static_cast<T>(parsed);
+}
+
+static EngineSettings GetLaunchSettings(int argc, char** argv)
+{
+    EngineSettings settings {};
+
+    settings.headless         = HasLaunchArg("--headless", nullptr, argc, argv);
+    settings.uncappedTickRate = HasLaunchArg("--uncapped", nullptr, argc, argv);
+
+    settings.parallelEntityTick = HasLaunchArg("--parallel-tick", nullptr, argc, argv);
+
+    GetLaunchArgNumber("--tickrate", settings.tickRate, 1, argc, argv);
+    GetLaunchArgNumber("--ticks", settings.maxTicks, 0, argc, argv);
+
+    settings.offscreen = HasLaunchArg("--offscreen", nullptr, argc, argv);
+
+    GetLaunchArgNumber("--width", settings.offscreenWidth, 1, argc, argv);
+    GetLaunchArgNumber("--height", settings.offscreenHeight, 1, argc, argv);
+    GetLaunchArgNumber("--frames", settings.maxFrames, 0, argc, argv);
+    GetLaunchArgNumber("--readback", settings.readbackInterval, 0, argc, argv);
+
+    if (auto directory = GetLaunchArg("--readback-dir", argc, argv))
+    {
+        settings.readbackDirectory = directory;
+    }
+
+    return settings;
+}
+
+static int LEGS_Init(int argc, char** argv)
 {
     try
     {
-        g_engine = std::make_shared<legs::Engine>();
+        g_engine = std::make_shared<legs::Engine>(GetLaunchSettings(argc, argv));
         return 0;
     }
     catch (std::exception& ex)
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <semaphore>
+#include <vector>
+
+namespace legs
+{
+// Single producer, single consumer ring of per-frame contexts.
+// The producer can run up to Depth() slots ahead of the consumer,
+// work queues up instead of being dropped while the consumer is busy.
+template<typename T>
+class FrameQueue
+{
+  public:
+    static constexpr std::ptrdiff_t MaxDepth = 8;
+
+    FrameQueue() = delete;
+    FrameQueue(unsigned int depth) :
+        m_slots(std::clamp(depth, 1u, static_cast<unsigned int>(MaxDepth))),
+        m_freeSlots(static_cast<std::ptrdiff_t>(m_slots.size()))
+    {
+    }
+
+    FrameQueue(const FrameQueue&)            = delete;
+    FrameQueue(FrameQueue&&)                 = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+    FrameQueue& operator=(FrameQueue&&)      = delete;
+
+    // Producer: get the next free slot, nullptr if the queue stays full for the whole timeout.
+    template<class Rep, class Period>
+    T* TryBeginWrite(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (!m_freeSlots.try_acquire_for(timeout))
+        {
+            return nullptr;
+        }
+        return &m_slots[m_writeIndex];
+    }
+
+    T* TryBeginWrite()
+    {
+        if (!m_freeSlots.try_acquire())
+        {
+            return nullptr;
+        }
+        return &m_slots[m_writeIndex];
+    }
+
+    // Producer: hand the slot from TryBeginWrite over to the consumer.
+    void EndWrite()
+    {
+        m_writeIndex = (m_writeIndex + 1) % m_slots.size();
+        m_size++;
+        m_filledSlots.release();
+    }
+
+    // Consumer: block until a slot is ready, nullptr once the queue is closed and empty.
+    // Slots written before Close are still read, so no queued work is lost.
+    T* BeginRead()
+    {
+        m_filledSlots.acquire();
+        if (m_closed && m_size == 0)
+        {
+            // Only Close releases without filling a slot, pass it on so later reads fail too.
+            m_filledSlots.release();
+            return nullptr;
+        }
+        return &m_slots[m_readIndex];
+    }
+
+    // Consumer: give the slot from BeginRead back to the producer.
+    void EndRead()
+    {
+        m_readIndex = (m_readIndex + 1) % m_slots.size();
+        m_size--;
+        m_freeSlots.release();
+    }
+
+    // Wake up the consumer and make reads fail once the filled slots are read.
+    void Close()
+    {
+        m_closed = true;
+        m_filledSlots.release();
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    size_t Depth() const
+    {
+        return m_slots.size();
+    }
+
+  private:
+    std::vector<T> m_slots;
+
+    std::counting_semaphore<MaxDepth>     m_freeSlots;
+    std::counting_semaphore<MaxDepth + 1> m_filledSlots {0};
+
+    size_t m_writeIndex = 0;
+    size_t m_readIndex  = 0;
+
+    std::atomic<size_t> m_size   = 0;
+    std::atomic<bool>   m_closed = false;
+};
+} // namespace legs
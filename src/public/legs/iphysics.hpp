@@ -22,12 +22,16 @@ class IPhysics
     virtual void Update()   = 0;
     virtual void Optimize() = 0;
 
+    // Thread pool the simulation runs on, idle between physics updates.
+    virtual JPH::JobSystem* GetJobSystem() = 0;
+
     virtual JPH::BodyID CreateBody(JPH::BodyCreationSettings settings) = 0;
     virtual void        AddBody(JPH::BodyID id)                        = 0;
     virtual void        RemoveBody(JPH::BodyID id)                     = 0;
     virtual void        DestroyBody(JPH::BodyID id)                    = 0;
 
     virtual void GetBodyTransform(JPH::BodyID id, std::shared_ptr<STransform> trans) = 0;
+    virtual void GetBodyTransform(JPH::BodyID id, STransform& trans)                 = 0;
     virtual void SetBodyTransform(JPH::BodyID id, std::shared_ptr<STransform> trans) = 0;
 
     virtual void SetBodyPosition(JPH::BodyID id, glm::vec3 pos)        = 0;
@@ -1,7 +1,83 @@
 #pragma once
 
+#include <set>
+#include <typeindex>
+
 namespace legs
 {
+// Components and resources a system reads and writes,
+// systems that don't conflict can run at the same time.
+class SystemAccess
+{
+  public:
+    template<typename T>
+    SystemAccess& Read()
+    {
+        m_reads.insert(typeid(T));
+        return *this;
+    }
+
+    template<typename T>
+    SystemAccess& Write()
+    {
+        m_writes.insert(typeid(T));
+        return *this;
+    }
+
+    // Conflicts with every other system, runs on the engine thread in the order it was added.
+    SystemAccess& Exclusive()
+    {
+        m_exclusive = true;
+        return *this;
+    }
+
+    bool IsExclusive() const
+    {
+        return m_exclusive;
+    }
+
+    bool ConflictsWith(const SystemAccess& other) const
+    {
+        if (m_exclusive || other.m_exclusive)
+        {
+            return true;
+        }
+
+        for (const auto& type : m_writes)
+        {
+            if (other.m_reads.contains(type) || other.m_writes.contains(type))
+            {
+                return true;
+            }
+        }
+
+        for (const auto& type : other.m_writes)
+        {
+            if (m_reads.contains(type))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    size_t ReadCount() const
+    {
+        return m_reads.size();
+    }
+
+    size_t WriteCount() const
+    {
+        return m_writes.size();
+    }
+
+  private:
+    std::set<std::type_index> m_reads;
+    std::set<std::type_index> m_writes;
+    bool                      m_exclusive = false;
+};
+
 class ISystem
 {
   public:
@@ -16,5 +92,17 @@ class ISystem
     virtual void OnLevelLoad() {};
     virtual void OnFrame() {};
     virtual void OnTick() {};
+
+    // Declare what OnFrame and OnTick touch to let them run on the job system
+    // alongside other systems. Systems that don't override this stay exclusive.
+    virtual void DeclareAccess(SystemAccess& access)
+    {
+        access.Exclusive();
+    }
+
+    virtual const char* GetName() const
+    {
+        return "System";
+    }
 };
 }; // namespace legs
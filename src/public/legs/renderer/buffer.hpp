@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include <legs/renderer/vma_usage.hpp>
 
@@ -12,6 +14,12 @@ enum BufferType
     VertexBuffer,
     IndexBuffer,
     UniformBuffer,
+    StorageBuffer,
+    StagingBuffer,
+    // Written by compute, read by indirect draws.
+    IndirectBuffer,
+    // Copy destination the host reads back, e.g. rendered frames.
+    ReadbackBuffer,
 };
 
 enum BufferLocation
@@ -20,15 +28,26 @@ enum BufferLocation
     DeviceBuffer,
 };
 
+// Whether the host writes a device buffer, host buffers are always writable.
+// Only then may it land in host visible device memory, which can be a small heap.
+enum BufferHostAccess
+{
+    NoHostAccess,
+    HostWriteAccess,
+};
+
 class Buffer
 {
   public:
     Buffer() = delete;
+    // Buffers used by more than one queue family list them all in queueFamilies.
     Buffer(
-        BufferType     bufferType,
-        BufferLocation bufferLocation,
-        uint32_t       elementSize,
-        uint32_t       elementCount
+        BufferType                   bufferType,
+        BufferLocation               bufferLocation,
+        uint32_t                     elementSize,
+        uint32_t                     elementCount,
+        const std::vector<uint32_t>& queueFamilies = {},
+        BufferHostAccess             hostAccess    = NoHostAccess
     );
 
     ~Buffer();
@@ -42,7 +61,7 @@ class Buffer
     requires std::contiguous_iterator<IT>
     void Write(const IT it, uint32_t length)
     {
-        if (m_bufferLocation != HostBuffer)
+        if (!m_isHostVisible)
         {
             throw std::runtime_error("Tried mapping a non-host buffer");
         }
@@ -57,7 +76,8 @@ class Buffer
         m_elementCount = length;
     }
 
-    void Write(void* data, size_t size);
+    // Works for any host visible buffer, device buffers included if IsHostVisible.
+    void Write(void* data, size_t size, size_t offset = 0);
 
     void CopyToDevice(void* commandBuffer, std::shared_ptr<Buffer> deviceBuffer);
 
@@ -65,12 +85,32 @@ class Buffer
 
     void Bind(void* commandBuffer);
 
-    void Draw(void* commandBuffer);
+    void Draw(void* commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
     void Draw(void* commandBuffer, uint32_t indexOffset, uint32_t indexCount, int32_t vertexOffset);
 
     void Map(void** data);
     void Unmap();
 
+    // Make host writes to a mapped range visible to the device.
+    void Flush(size_t offset, size_t size);
+
+    // Uploads into the buffer still in flight on the transfer queue.
+    void BeginUpload()
+    {
+        m_pendingUploads++;
+    }
+
+    void EndUpload()
+    {
+        m_pendingUploads--;
+    }
+
+    // Whether every upload into the buffer has finished and it can be drawn.
+    bool IsReady() const
+    {
+        return m_pendingUploads == 0;
+    }
+
     VkBuffer GetVkBuffer() const
     {
         return m_vkBuffer;
@@ -96,6 +136,13 @@ class Buffer
         return m_bufferLocation;
     }
 
+    // Device buffers created with HostWriteAccess can end up in memory that is both
+    // device local and host visible, those can be written directly without a staging copy.
+    bool IsHostVisible() const
+    {
+        return m_isHostVisible;
+    }
+
     size_t GetSize() const
     {
         return m_size;
@@ -106,6 +153,12 @@ class Buffer
         return m_elementSize;
     }
 
+    // Unique per buffer for the lifetime of the program, until 2^32 buffers wrap it.
+    uint32_t GetId() const
+    {
+        return m_id;
+    }
+
   private:
     VkBuffer      m_vkBuffer;
     VmaAllocation m_vmaAllocation;
@@ -115,6 +168,10 @@ class Buffer
     uint32_t       m_elementSize;
     uint32_t       m_elementCount;
     size_t         m_size;
-    bool           m_isMapped = false;
+    uint32_t       m_id;
+    bool           m_isMapped      = false;
+    bool           m_isHostVisible = false;
+
+    std::atomic<uint32_t> m_pendingUploads = 0;
 };
 } // namespace legs
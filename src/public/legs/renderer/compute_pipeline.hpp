@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include <vulkan/vulkan_core.h>
+
+#include <legs/renderer/descriptor_set.hpp>
+#include <legs/renderer/device.hpp>
+
+namespace legs
+{
+// Compute counterpart of Pipeline, sharing the same descriptor set.
+// Push constants of pushConstantSize bytes are visible to the compute stage.
+class ComputePipeline
+{
+  public:
+    ComputePipeline() = delete;
+    ComputePipeline(
+        const Device&                   device,
+        std::shared_ptr<DescriptorSet>  descriptorSet,
+        VkPipelineShaderStageCreateInfo shaderStage,
+        uint32_t                        pushConstantSize = 0
+    );
+    ~ComputePipeline();
+
+    ComputePipeline(const ComputePipeline&)            = delete;
+    ComputePipeline(ComputePipeline&&)                 = delete;
+    ComputePipeline& operator=(const ComputePipeline&) = delete;
+    ComputePipeline& operator=(ComputePipeline&&)      = delete;
+
+    void Bind(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    void PushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size);
+
+  private:
+    const Device&                  m_device;
+    std::shared_ptr<DescriptorSet> m_descriptorSet;
+
+    VkPipelineLayout m_vkPipelineLayout;
+    VkPipeline       m_vkPipeline;
+};
+} // namespace legs
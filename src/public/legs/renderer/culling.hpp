@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <legs/renderer/mesh_data.hpp>
+
+namespace legs
+{
+// Threads per workgroup of the culling compute shader.
+static constexpr uint32_t CullGroupSize = 64;
+
+// One object for the culling compute shader, matches CullObject in cull_comp.comp.
+// Visible objects get a draw command in their batch's range of the indirect buffer.
+struct alignas(16) SCullObject
+{
+    // Bounding sphere in mesh space, xyz center and w radius.
+    glm::vec4 bounds;
+    uint32_t  firstIndex;
+    uint32_t  indexCount;
+    int32_t   vertexOffset;
+    // First draw command of the batch, and its slot in the draw count buffer.
+    uint32_t firstCommand;
+    uint32_t batch;
+    // Model matrix, also used as the instance of the draw.
+    uint32_t model;
+};
+
+static_assert(sizeof(SCullObject) == 48, "SCullObject must match the std430 layout");
+
+// Planes of a view frustum, normals point inwards and normalized,
+// so a point's signed distance is dot(plane.xyz, point) + plane.w.
+struct SFrustum
+{
+    std::array<glm::vec4, 6> planes;
+
+    // Expects 0..1 depth like the camera's projection.
+    static SFrustum FromViewProjection(const glm::mat4& viewProjection);
+};
+
+// Bounding sphere in world space as xyz center and w radius,
+// scaled by the largest scale on any axis of the model matrix.
+glm::vec4 TransformBoundingSphere(const SBoundingSphere& bounds, const glm::mat4& model);
+
+// Test world space spheres (xyz center, w radius) against a frustum, four at a time.
+// visible[i] is set for every sphere at least partially inside, returns how many are.
+uint32_t CullSpheres(
+    const SFrustum&               frustum,
+    const std::vector<glm::vec4>& spheres,
+    std::vector<uint8_t>&         visible
+);
+} // namespace legs
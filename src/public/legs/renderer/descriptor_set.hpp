@@ -1,19 +1,41 @@
 #pragma once
 
+#include <array>
+#include <optional>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
 #include <vulkan/vulkan_core.h>
 
 #include <legs/renderer/buffer.hpp>
+#include <legs/renderer/culling.hpp>
 #include <legs/renderer/device.hpp>
 #include <legs/renderer/mesh_data.hpp>
 #include <legs/renderer/ubo.hpp>
 
 namespace legs
 {
+// Largest block of per-draw data, the range of the dynamic uniform buffer in shaders.
+static constexpr uint32_t MaxDrawDataSize = 256;
+
+// Descriptor sets by how often they change, also their set numbers in the shaders.
+// PerFrame: frame uniforms and the culling buffers,
+// PerView: camera uniforms, only rewritten when the view changes,
+// PerObject: model matrices and the dynamic per-draw data, rebound between draws.
+enum DescriptorFrequency
+{
+    PerFrame,
+    PerView,
+    PerObject,
+};
+
+static constexpr uint32_t DescriptorFrequencyCount = 3;
+
 class DescriptorSet
 {
   public:
     DescriptorSet() = delete;
-    DescriptorSet(const Device& device, std::vector<std::shared_ptr<Buffer>> uboBuffers);
+    DescriptorSet(const Device& device, uint32_t maxFramesInFlight);
     ~DescriptorSet();
 
     DescriptorSet(const DescriptorSet&)            = delete;
@@ -21,13 +43,61 @@ class DescriptorSet
     DescriptorSet& operator=(const DescriptorSet&) = delete;
     DescriptorSet& operator=(DescriptorSet&&)      = delete;
 
-    void UpdateUBO(uint32_t frameIndex, const std::shared_ptr<UniformBufferObject> ubo);
+    void UpdateFrameUBO(uint32_t frameIndex, const FrameBufferObject& ubo);
+
+    // Skipped if the frame's set already has this revision of the view,
+    // revision 0 always writes.
+    void UpdateViewUBO(uint32_t frameIndex, const ViewBufferObject& ubo, uint64_t revision);
+
+    // Upload model matrices for a frame, indexed by instance in the shaders.
+    // Grows the frame's storage buffer if needed.
+    void UpdateObjects(uint32_t frameIndex, const std::vector<glm::mat4>& models);
 
+    // Upload objects for the culling compute shader, with room for a draw command
+    // per object and a draw count per batch. Grows the frame's buffers if needed.
+    void UpdateCullObjects(
+        uint32_t                        frameIndex,
+        const std::vector<SCullObject>& objects,
+        uint32_t                        batchCount
+    );
+
+    // Per-draw data goes into a ring of uniform memory per frame, bump allocated
+    // and handed to the shaders by the dynamic offset the set is bound with.
+    // Returns the offset, or nothing if the frame's ring is full.
+    std::optional<uint32_t> WriteDrawData(uint32_t frameIndex, const void* data, uint32_t size);
+
+    // Start over at the beginning of a frame's ring, once its fence has signaled.
+    void ResetDrawData(uint32_t frameIndex)
+    {
+        m_drawDataOffsets[frameIndex] = 0;
+    }
+
+    std::shared_ptr<Buffer> GetDrawCommandBuffer(uint32_t frameIndex) const
+    {
+        return m_drawCommandBuffers[frameIndex];
+    }
+
+    std::shared_ptr<Buffer> GetDrawCountBuffer(uint32_t frameIndex) const
+    {
+        return m_drawCountBuffers[frameIndex];
+    }
+
+    // Bind the frame's sets of every frequency.
     void Bind(
         VkCommandBuffer     commandBuffer,
         VkPipelineBindPoint bindPoint,
         VkPipelineLayout    pipelineLayout,
-        uint32_t            frameIndex
+        uint32_t            frameIndex,
+        uint32_t            drawDataOffset = 0
+    );
+
+    // Rebind only the per-object set, the frame and view sets stay bound.
+    void BindObjects(
+        VkCommandBuffer     commandBuffer,
+        VkPipelineBindPoint bindPoint,
+        VkPipelineLayout    pipelineLayout,
+        uint32_t            frameIndex,
+        uint32_t            drawDataOffset
     );
 
     std::vector<VkDescriptorSetLayout> GetLayouts() const
@@ -36,10 +106,41 @@ class DescriptorSet
     }
 
   private:
+    void CreateObjectBuffer(uint32_t frameIndex, uint32_t capacity);
+    void CreateCullBuffers(uint32_t frameIndex, uint32_t capacity);
+    void CreateDrawCountBuffer(uint32_t frameIndex, uint32_t capacity);
+    void CreateLayout(
+        DescriptorFrequency                              frequency,
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings
+    );
+    void WriteDescriptor(
+        uint32_t                       frameIndex,
+        DescriptorFrequency            frequency,
+        uint32_t                       binding,
+        VkDescriptorType               type,
+        const std::shared_ptr<Buffer>& buffer,
+        VkDeviceSize                   range = VK_WHOLE_SIZE
+    );
+
+    using FrameSets = std::array<VkDescriptorSet, DescriptorFrequencyCount>;
+
     const Device&                        m_device;
     std::vector<VkDescriptorSetLayout>   m_vkLayouts;
-    std::vector<VkDescriptorSet>         m_vkSets;
-    std::vector<std::shared_ptr<Buffer>> m_uniformBuffers;
-    std::vector<void*>                   m_ubosMappedMemory;
+    std::vector<FrameSets>               m_vkSets;
+    std::vector<std::shared_ptr<Buffer>> m_frameBuffers;
+    std::vector<void*>                   m_frameMappedMemory;
+    std::vector<std::shared_ptr<Buffer>> m_viewBuffers;
+    std::vector<void*>                   m_viewMappedMemory;
+    std::vector<uint64_t>                m_viewRevisions;
+    std::vector<std::shared_ptr<Buffer>> m_objectBuffers;
+    std::vector<void*>                   m_objectsMappedMemory;
+    std::vector<std::shared_ptr<Buffer>> m_cullBuffers;
+    std::vector<void*>                   m_cullMappedMemory;
+    std::vector<std::shared_ptr<Buffer>> m_drawCommandBuffers;
+    std::vector<std::shared_ptr<Buffer>> m_drawCountBuffers;
+    std::vector<std::shared_ptr<Buffer>> m_drawDataBuffers;
+    std::vector<void*>                   m_drawDataMappedMemory;
+    std::vector<uint32_t>                m_drawDataOffsets;
+    uint32_t                             m_drawDataAlignment;
 };
 } // namespace legs
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <vector>
 
 #include <legs/components/rect.hpp>
+#include <legs/renderer/buffer.hpp>
 #include <legs/renderer/instance.hpp>
+#include <legs/renderer/readback.hpp>
 #include <legs/renderer/vma_usage.hpp>
 
 namespace legs
@@ -12,6 +18,8 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // Dedicated copy engine if there is one, graphics otherwise.
+    std::optional<uint32_t> transferFamily;
 
     bool IsComplete() const
     {
@@ -29,7 +37,14 @@ struct SwapchainSupportDetails
 class Device
 {
   public:
-    Device(const Instance& instance, uint32_t maxFramesInFlight);
+    // With an offscreen instance frames render into images of offscreenExtent
+    // instead of a swapchain, and Present only moves on to the next frame.
+    Device(
+        const Instance& instance,
+        uint32_t        maxFramesInFlight,
+        uint32_t        recorderCount,
+        VkExtent2D      offscreenExtent = {}
+    );
     ~Device();
 
     Device(const Device&)            = delete;
@@ -44,14 +59,56 @@ class Device
     void Present();
     void WaitForGraphicsIdle();
 
+    bool IsOffscreen() const
+    {
+        return m_instance.IsOffscreen();
+    }
+
+    // Offscreen only: copy the frame being recorded back to host memory, call between
+    // Begin and Submit. The copy is fenced with the frame, callback runs on the render
+    // thread once the frame's slot comes around again, so nothing waits on the GPU.
+    void ReadbackFrame(ReadbackCallback callback);
+
+    // Wait for frames with a pending readback and run their callbacks.
+    void FlushReadbacks();
+
+    // Keep a resource alive until the GPU is done with the frame being recorded.
+    void DeferRelease(std::shared_ptr<void> resource)
+    {
+        m_releaseQueues[m_currentFrame].push_back(std::move(resource));
+    }
+
     VkCommandBuffer GetTemporaryCommandBuffer();
     void            SubmitTemporaryCommandBuffer(VkCommandBuffer commandBuffer);
 
+    // Submit to the transfer queue, safe to call from any thread.
+    void SubmitTransfer(const VkSubmitInfo& submitInfo, VkFence fence);
+
     VkCommandBuffer GetCommandBuffer() const
     {
         return m_vkCommandBuffers[m_currentFrame];
     }
 
+    // Each recorder has its own pool per frame in flight, so recorders can fill their
+    // secondary command buffers on separate threads. The buffers inherit the frame's
+    // attachments and viewport, and run in order with ExecuteSecondaryCommandBuffers.
+    uint32_t GetRecorderCount() const
+    {
+        return m_recorderCount;
+    }
+
+    VkCommandBuffer BeginSecondaryCommandBuffer(uint32_t recorder);
+    void            EndSecondaryCommandBuffer(uint32_t recorder);
+    void            ExecuteSecondaryCommandBuffers(uint32_t recorderCount);
+
+    // Submitted ahead of the frame's command buffer, outside of rendering.
+    // For compute work the frame's draws consume, its shader writes are
+    // visible to indirect draws.
+    VkCommandBuffer GetPrePassCommandBuffer() const
+    {
+        return m_vkPrePassCommandBuffers[m_currentFrame];
+    }
+
     uint32_t GetCurrentFrame() const
     {
         return m_currentFrame;
@@ -93,6 +150,12 @@ class Device
         return VK_FORMAT_D32_SFLOAT;
     }
 
+    // Shared by every pipeline, persisted to disk between runs.
+    VkPipelineCache GetPipelineCache() const
+    {
+        return m_vkPipelineCache;
+    }
+
     VkDescriptorPool GetUboDescriptorPool() const
     {
         return m_vkUboDescriptorPool;
@@ -113,10 +176,21 @@ class Device
         return m_vkGraphicsQueue;
     }
 
+    uint32_t GetTransferQueueIndex() const
+    {
+        return m_vkTransferQueueIndex;
+    }
+
   private:
+    // Transfers come from any thread, so whichever queue they go to is locked.
+    // Graphics and present are render thread only unless they are that queue.
+    std::unique_lock<std::mutex> LockSharedQueue(VkQueue queue);
+
     void RecreateSwapchain();
     void DestroySwapchain();
 
+    std::vector<const char*> GetRequiredExtensions() const;
+
     void               PickPhysicalDevice();
     bool               IsDeviceSuitable(const VkPhysicalDevice device);
     QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice device);
@@ -130,6 +204,8 @@ class Device
     );
     constexpr VkExtent2D       ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
     void                       CreateSwapchain();
+    void                       CreateOffscreenTargets();
+    void                       CreateDepthImage();
 
     void CreateImage(
         VkImage*          image,
@@ -153,11 +229,23 @@ class Device
 
     void CreateCommandPool();
     void CreateCommandBuffers();
+    void CreateRecorders();
+
+    // Start a render pass instance on the frame's attachments,
+    // recorded inline or only from secondary command buffers.
+    void BeginRendering(VkAttachmentLoadOp loadOp, VkRenderingFlags flags);
+    void EndRendering();
 
     void CreateSyncObjects();
 
     void CreateDescriptorPools();
 
+    void CreatePipelineCache();
+    void SavePipelineCache();
+
+    void RecordReadback();
+    void DeliverReadback(uint32_t frame);
+
     const Instance& m_instance;
 
     VkPhysicalDevice m_vkPhysicalDevice;
@@ -165,9 +253,13 @@ class Device
 
     uint32_t m_vkGraphicsQueueIndex;
     uint32_t m_vkPresentQueueIndex;
+    uint32_t m_vkTransferQueueIndex;
 
     VkQueue m_vkGraphicsQueue;
     VkQueue m_vkPresentQueue;
+    VkQueue m_vkTransferQueue;
+
+    std::mutex m_queueMutex;
 
     VkSwapchainKHR           m_vkSwapchain;
     std::vector<VkImage>     m_vkSwapchainImages;
@@ -175,29 +267,54 @@ class Device
     VkExtent2D               m_vkSwapchainExtent;
     std::vector<VkImageView> m_vkSwapchainImageViews;
 
+    // Offscreen only, stand in for the swapchain images, one per frame in flight.
+    std::vector<VmaAllocation> m_vmaOffscreenAllocations;
+
     VkImage       m_vkDepthImage;
     VmaAllocation m_vmaDepthAllocation;
     VkImageView   m_vkDepthImageView;
 
     VkCommandPool                m_vkCommandPool;
     std::vector<VkCommandBuffer> m_vkCommandBuffers;
+    std::vector<VkCommandBuffer> m_vkPrePassCommandBuffers;
+
+    // Per frame in flight, one per recorder.
+    std::vector<std::vector<VkCommandPool>>   m_vkRecorderPools;
+    std::vector<std::vector<VkCommandBuffer>> m_vkSecondaryCommandBuffers;
+    const uint32_t                            m_recorderCount;
 
     std::vector<VkSemaphore> m_vkImageSemaphores;
     std::vector<VkSemaphore> m_vkRenderSemaphores;
     std::vector<VkFence>     m_vkInFlightFences;
 
+    // Per frame in flight, emptied once the frame's fence has signaled.
+    std::vector<std::vector<std::shared_ptr<void>>> m_releaseQueues;
+
+    struct SReadback
+    {
+        std::shared_ptr<Buffer> buffer;
+        void*                   mapped = nullptr;
+        VkExtent2D              extent {};
+        ReadbackCallback        callback;
+    };
+
+    // Per frame in flight, buffers are kept for the next readback of the same size.
+    std::vector<SReadback> m_readbacks;
+
     VkDescriptorPool m_vkUboDescriptorPool;
     VkDescriptorPool m_vkImGuiDescriptorPool;
 
+    VkPipelineCache m_vkPipelineCache;
+
+    // Last set with ResetViewport or SetViewport, secondaries start with them too.
+    VkViewport m_viewport;
+    VkRect2D   m_scissor;
+
     uint32_t       m_currentImageIndex;
     uint32_t       m_currentFrame = 0;
     const uint32_t m_maxFramesInFlight;
 
-    bool m_frameBufferResized = false;
-
-    const std::vector<const char*> m_requiredExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
-    };
+    // Set from the thread that handles window events, cleared by Present.
+    std::atomic<bool> m_frameBufferResized = false;
 };
 } // namespace legs
@@ -10,6 +10,7 @@ namespace legs
 class Instance
 {
   public:
+    // Without a window there is no surface, devices render offscreen.
     Instance(std::shared_ptr<Window> window);
     ~Instance();
 
@@ -28,6 +29,11 @@ class Instance
         return m_vkSurface;
     }
 
+    bool IsOffscreen() const
+    {
+        return m_window == nullptr;
+    }
+
     void GetFramebufferSize(int* width, int* height) const
     {
         m_window->GetFramebufferSize(width, height);
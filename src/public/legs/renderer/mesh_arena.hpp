@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include <legs/renderer/buffer.hpp>
+#include <legs/renderer/mesh_data.hpp>
+#include <legs/renderer/uploader.hpp>
+
+namespace legs
+{
+// First-fit allocator over a range of elements, neighbouring free blocks get merged.
+class FreeList
+{
+  public:
+    std::optional<uint32_t> Allocate(uint32_t count)
+    {
+        for (auto it = m_free.begin(); it != m_free.end(); it++)
+        {
+            if (it->second < count)
+            {
+                continue;
+            }
+
+            const auto offset    = it->first;
+            const auto remaining = it->second - count;
+            m_free.erase(it);
+            if (remaining > 0)
+            {
+                m_free.emplace(offset + count, remaining);
+            }
+
+            m_used += count;
+            return offset;
+        }
+        return std::nullopt;
+    }
+
+    void Free(uint32_t offset, uint32_t count)
+    {
+        m_used -= count;
+
+        auto next = m_free.lower_bound(offset);
+        if (next != m_free.end() && offset + count == next->first)
+        {
+            count += next->second;
+            next   = m_free.erase(next);
+        }
+
+        if (next != m_free.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset)
+            {
+                prev->second += count;
+                return;
+            }
+        }
+
+        m_free.emplace_hint(next, offset, count);
+    }
+
+    // Add free space at the end.
+    void Grow(uint32_t capacity)
+    {
+        if (capacity <= m_capacity)
+        {
+            return;
+        }
+
+        const auto added = capacity - m_capacity;
+        m_used += added;
+        Free(m_capacity, added);
+        m_capacity = capacity;
+    }
+
+    // Forget every allocation, used to pack everything again from the start.
+    void Reset()
+    {
+        m_free.clear();
+        m_used = 0;
+        if (m_capacity > 0)
+        {
+            m_free.emplace(0, m_capacity);
+        }
+    }
+
+    uint32_t GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+    uint32_t GetUsed() const
+    {
+        return m_used;
+    }
+
+    // Packed when all free space is one block at the end.
+    bool IsFragmented() const
+    {
+        if (m_free.empty())
+        {
+            return false;
+        }
+
+        const auto& [offset, count] = *m_free.begin();
+        return m_free.size() > 1 || offset + count != m_capacity;
+    }
+
+  private:
+    // Offset to size of every free block.
+    std::map<uint32_t, uint32_t> m_free;
+    uint32_t                     m_capacity = 0;
+    uint32_t                     m_used     = 0;
+};
+
+// Where a mesh lives in the arena's buffers.
+// Defragmenting moves meshes around, so read the ranges at draw time instead of keeping them.
+struct SMeshAllocation
+{
+    VertexFormat format;
+    uint32_t     vertexOffset;
+    uint32_t     vertexCount;
+    uint32_t     firstIndex;
+    uint32_t     indexCount;
+
+    SBoundingSphere bounds;
+
+    // Arena generation the ranges are valid from, see MeshArena::BeginFrame.
+    uint64_t generation;
+
+    std::shared_future<void> uploaded;
+
+    bool IsUploaded() const
+    {
+        return uploaded.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+};
+
+// Suballocates meshes out of one large vertex buffer per vertex format and a shared index
+// buffer, so draws only differ in firstIndex and vertexOffset and rarely rebind anything.
+// Buffers grow by copying on the transfer queue, Defragment packs them back together.
+// Freeing happens when the last handle to a mesh goes away.
+class MeshArena : public std::enable_shared_from_this<MeshArena>
+{
+  public:
+    MeshArena() = delete;
+    MeshArena(Uploader& uploader, std::vector<uint32_t> queueFamilies);
+    ~MeshArena() = default;
+
+    MeshArena(const MeshArena&)            = delete;
+    MeshArena(MeshArena&&)                 = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+    MeshArena& operator=(MeshArena&&)      = delete;
+
+    // Safe to call from any thread.
+    template<typename V>
+    std::shared_ptr<SMeshAllocation> Create(
+        const std::vector<V>&     vertices,
+        const std::vector<Index>& indices
+    )
+    {
+        return Create(
+            GetVertexFormat<V>(),
+            sizeof(V),
+            vertices.data(),
+            static_cast<uint32_t>(vertices.size()),
+            indices,
+            ComputeBoundingSphere(vertices)
+        );
+    }
+
+    // Pack every buffer with free holes in it into a new one, render thread only.
+    // Meshes in a packed buffer are skipped until its copy finishes, so this is
+    // meant for loading screens and the like.
+    void Defragment();
+
+    // Pick up the current buffers for the frame being recorded, render thread only.
+    // Buffers swapped by growth during the frame don't affect it.
+    void BeginFrame();
+
+    // Buffers to draw a format from this frame, false if there are none yet.
+    bool GetFrameBuffers(
+        VertexFormat             format,
+        std::shared_ptr<Buffer>& vertexBuffer,
+        std::shared_ptr<Buffer>& indexBuffer
+    ) const;
+
+    // Whether a mesh is uploaded and inside the buffers picked up by BeginFrame.
+    bool IsDrawable(const SMeshAllocation& mesh) const
+    {
+        return mesh.generation <= m_frameGeneration && mesh.IsUploaded();
+    }
+
+  private:
+    static constexpr size_t FormatCount = static_cast<size_t>(VertexFormat::MAX);
+
+    struct SPool
+    {
+        BufferType              type        = VertexBuffer;
+        uint32_t                elementSize = 0;
+        std::shared_ptr<Buffer> buffer;
+        FreeList                freeList;
+        // Copy into the buffer from the one it replaced, if any.
+        std::shared_future<void> copied;
+    };
+
+    std::shared_ptr<SMeshAllocation> Create(
+        VertexFormat              format,
+        uint32_t                  vertexSize,
+        const void*               vertices,
+        uint32_t                  vertexCount,
+        const std::vector<Index>& indices,
+        const SBoundingSphere&    bounds
+    );
+    void Free(SMeshAllocation* mesh);
+
+    uint32_t Allocate(SPool& pool, uint32_t count);
+    void     Grow(SPool& pool, uint32_t capacity);
+    // Vertex pools pass their format, the index pool is shared by all of them.
+    void Pack(SPool& pool, std::optional<VertexFormat> format);
+
+    std::shared_future<void> Write(SPool& pool, uint32_t offset, const void* data, uint32_t count);
+
+    Uploader&                   m_uploader;
+    const std::vector<uint32_t> m_queueFamilies;
+
+    std::mutex                           m_mutex;
+    std::array<SPool, FormatCount>       m_vertexPools;
+    SPool                                m_indexPool;
+    std::unordered_set<SMeshAllocation*> m_meshes;
+    uint64_t                             m_generation = 0;
+
+    // Render thread only.
+    std::array<std::shared_ptr<Buffer>, FormatCount> m_frameVertexBuffers;
+    std::shared_ptr<Buffer>                          m_frameIndexBuffer;
+    uint64_t                                         m_frameGeneration = 0;
+};
+} // namespace legs
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <glm/vec3.hpp>
 
 #include <legs/renderer/common.hpp>
@@ -34,6 +39,69 @@ struct VertexEmpty
 
 typedef uint32_t Index;
 
+// Sphere around a mesh's vertices, in the mesh's own space.
+struct SBoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float     radius = 0.0f;
+};
+
+// Centered on the vertices' bounding box, which is close enough for culling.
+template<typename V>
+SBoundingSphere ComputeBoundingSphere(const std::vector<V>& vertices)
+{
+    if (vertices.empty())
+    {
+        return {};
+    }
+
+    auto min = glm::vec3(std::numeric_limits<float>::max());
+    auto max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    SBoundingSphere sphere;
+    sphere.center = (min + max) * 0.5f;
+    for (const auto& vertex : vertices)
+    {
+        sphere.radius = std::max(sphere.radius, glm::distance(sphere.center, vertex.position));
+    }
+    return sphere;
+}
+
+// Vertex layouts that get their own buffer in the mesh arena.
+enum class VertexFormat
+{
+    P,
+    P_C,
+    P_N_C,
+    MAX
+};
+
+template<typename T>
+consteval VertexFormat GetVertexFormat()
+{
+    if constexpr (std::is_same_v<T, Vertex_P>)
+    {
+        return VertexFormat::P;
+    }
+    else if constexpr (std::is_same_v<T, Vertex_P_C>)
+    {
+        return VertexFormat::P_C;
+    }
+    else if constexpr (std::is_same_v<T, Vertex_P_N_C>)
+    {
+        return VertexFormat::P_N_C;
+    }
+    else
+    {
+        static_assert(false, "Unhandled type for vertex format");
+    }
+}
+
 template<typename T>
 consteval VkVertexInputBindingDescription GetBindingDescription()
 {
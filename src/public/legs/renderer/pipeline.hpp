@@ -10,6 +10,9 @@
 
 namespace legs
 {
+// Push constants every graphics pipeline has room for, the minimum any device supports.
+static constexpr uint32_t MaxPushConstantSize = 128;
+
 template<class V>
 class Pipeline
 {
@@ -31,6 +34,31 @@ class Pipeline
 
     void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, uint32_t frameIndex);
 
+    // Small per-draw data, visible to the vertex and fragment stages.
+    void PushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size)
+    {
+        vkCmdPushConstants(
+            commandBuffer,
+            m_vkPipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            size,
+            data
+        );
+    }
+
+    // Rebind the per-object set with this draw's block of per-draw data.
+    void BindDrawData(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t offset)
+    {
+        m_descriptorSet->BindObjects(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            m_vkPipelineLayout,
+            frameIndex,
+            offset
+        );
+    }
+
     VkPipeline GetVkPipeline() const
     {
         return m_vkPipeline;
@@ -138,10 +166,17 @@ Pipeline<V>::Pipeline(
 
     auto descriptorSetLayouts = descriptorSet->GetLayouts();
 
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = MaxPushConstantSize;
+
     VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
-    pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-    pipelineLayoutInfo.pSetLayouts    = descriptorSetLayouts.data();
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts            = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
 
     VK_CHECK(
         vkCreatePipelineLayout(
@@ -195,7 +230,7 @@ Pipeline<V>::Pipeline(
     VK_CHECK(
         vkCreateGraphicsPipelines(
             m_device.GetVkDevice(),
-            VK_NULL_HANDLE,
+            m_device.GetPipelineCache(),
             1,
             &graphicsCreateInfo,
             nullptr,
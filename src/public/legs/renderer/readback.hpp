@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <vulkan/vulkan_core.h>
+
+namespace legs
+{
+// A rendered frame copied back to host memory, tightly packed rows of 4 byte pixels.
+// Pixels are only valid for the duration of the callback they were handed to.
+struct SReadbackImage
+{
+    uint32_t       width;
+    uint32_t       height;
+    VkFormat       format;
+    const uint8_t* pixels;
+};
+
+using ReadbackCallback = std::function<void(const SReadbackImage& image)>;
+
+// Write an 8 bit RGBA or BGRA image as a binary PPM, alpha is dropped.
+// Returns false if the file couldn't be written or the format isn't supported.
+bool WritePPM(const std::string& path, const SReadbackImage& image);
+} // namespace legs
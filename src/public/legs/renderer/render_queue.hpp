@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace legs
+{
+// A draw waiting to be sorted, object is whatever the submitter uses to find it again.
+struct SDrawPacket
+{
+    uint64_t key;
+    uint32_t object;
+};
+
+// Collects draw packets for a frame and sorts them by key,
+// so draws sharing state end up next to each other.
+class RenderQueue
+{
+  public:
+    RenderQueue()  = default;
+    ~RenderQueue() = default;
+
+    RenderQueue(const RenderQueue&)            = delete;
+    RenderQueue(RenderQueue&&)                 = delete;
+    RenderQueue& operator=(const RenderQueue&) = delete;
+    RenderQueue& operator=(RenderQueue&&)      = delete;
+
+    // Pipeline in the top 8 bits, then 20 bits of each buffer id and 16 bits of depth.
+    // Ids are truncated, so equal keys don't guarantee equal buffers, only likely ones.
+    // Depth is the distance from the camera, nearer draws sort first.
+    static uint64_t MakeKey(
+        uint32_t pipeline,
+        uint32_t vertexBufferId,
+        uint32_t indexBufferId,
+        float    depth
+    );
+
+    void Clear()
+    {
+        m_packets.clear();
+    }
+
+    void Submit(uint64_t key, uint32_t object)
+    {
+        m_packets.push_back({key, object});
+    }
+
+    // Stable LSD radix sort on the keys, a byte at a time.
+    // Bytes that are the same in every key are skipped.
+    void Sort();
+
+    const std::vector<SDrawPacket>& GetPackets() const
+    {
+        return m_packets;
+    }
+
+  private:
+    std::vector<SDrawPacket> m_packets;
+    std::vector<SDrawPacket> m_scratch;
+};
+} // namespace legs
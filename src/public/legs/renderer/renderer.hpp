@@ -1,18 +1,29 @@
 #pragma once
 
+#include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
+#include <vector>
 
 #include <imgui_impl_vulkan.h>
 
+#include <legs/jolt_pch.hpp>
+
 #include <legs/entity/camera.hpp>
 #include <legs/renderer/buffer.hpp>
 #include <legs/renderer/common.hpp>
+#include <legs/renderer/compute_pipeline.hpp>
+#include <legs/renderer/culling.hpp>
 #include <legs/renderer/descriptor_set.hpp>
 #include <legs/renderer/device.hpp>
 #include <legs/renderer/instance.hpp>
+#include <legs/renderer/mesh_arena.hpp>
 #include <legs/renderer/pipeline.hpp>
 #include <legs/renderer/ubo.hpp>
+#include <legs/renderer/uploader.hpp>
 
 namespace legs
 {
@@ -25,10 +36,34 @@ enum RenderPipeline
     SKY,
 };
 
+// How to build one of the graphics pipelines, its vertex type comes from the pipeline.
+struct SPipelineDesc
+{
+    RenderPipeline           pipeline;
+    VkShaderModuleCreateInfo vertexShader;
+    VkShaderModuleCreateInfo fragmentShader;
+    bool                     enableCulling = true;
+    bool                     enableDepth   = true;
+    // Built on the first BindPipeline instead of at startup.
+    bool lazy = false;
+};
+
+// One instanced draw of a mesh with its own buffers, see Renderer::DrawList.
+struct SDraw
+{
+    RenderPipeline          pipeline;
+    std::shared_ptr<Buffer> vertexBuffer;
+    std::shared_ptr<Buffer> indexBuffer;
+    uint32_t                instanceCount;
+    uint32_t                firstInstance;
+};
+
 class Renderer
 {
   public:
-    Renderer(std::shared_ptr<Window> window);
+    // Without a window frames render offscreen at offscreenExtent,
+    // see ReadbackFrame for getting them back.
+    Renderer(std::shared_ptr<Window> window, VkExtent2D offscreenExtent = {});
     ~Renderer();
 
     Renderer(const Renderer&)            = delete;
@@ -57,9 +92,89 @@ class Renderer
     void  UpdateUBO();
     void  WaitForIdle();
 
-    std::shared_ptr<UniformBufferObject> GetUBO()
+    bool IsOffscreen() const
+    {
+        return m_device.IsOffscreen();
+    }
+
+    // Offscreen only: read the frame being recorded back once the GPU is done with it,
+    // without waiting for it. callback runs on the render thread a few frames later,
+    // or in WaitForIdle for the last frames.
+    void ReadbackFrame(ReadbackCallback callback)
+    {
+        m_device.ReadbackFrame(std::move(callback));
+    }
+
+    // Upload this frame's model matrices, must happen before the first draw.
+    // Draws pick theirs with the firstInstance of DrawWithBuffers.
+    // Objects added for culling go up as well and get culled before the frame renders.
+    void UpdateObjects(const std::vector<glm::mat4>& models);
+
+    // Add an arena mesh to be frustum culled on the GPU and drawn by DrawCulled,
+    // model is its matrix in the next UpdateObjects.
+    void AddCulledObject(
+        RenderPipeline                          pipeline,
+        const std::shared_ptr<SMeshAllocation>& mesh,
+        uint32_t                                model
+    );
+
+    // Draw whatever survived culling, one indirect draw per pipeline and vertex format.
+    void DrawCulled();
+
+    // Test world space bounding spheres (xyz center, w radius) against the frustum
+    // of the current view, before anything using them is drawn.
+    // visible[i] is set for the spheres to draw, counts go into the culling stats.
+    void CullSpheres(const std::vector<glm::vec4>& spheres, std::vector<uint8_t>& visible);
+
+    // Draw calls recorded since Begin, render thread only.
+    uint32_t GetDrawCalls() const
+    {
+        return m_drawCalls;
+    }
+
+    // Objects that passed or failed CullSpheres since Begin, render thread only.
+    uint32_t GetVisibleObjects() const
+    {
+        return m_visibleObjects;
+    }
+
+    uint32_t GetCulledObjects() const
+    {
+        return m_culledObjects;
+    }
+
+    // Pipeline and vertex or index buffer binds since Begin, render thread only.
+    uint32_t GetPipelineBinds() const
+    {
+        return m_pipelineBinds;
+    }
+
+    uint32_t GetBufferBinds() const
     {
-        return m_ubo;
+        return m_bufferBinds;
+    }
+
+    // Objects handed to the GPU for culling this frame, render thread only.
+    uint32_t GetGPUCulledObjects() const
+    {
+        return m_gpuCulledObjects;
+    }
+
+    std::shared_ptr<FrameBufferObject> GetFrameUBO()
+    {
+        return m_frameUbo;
+    }
+
+    const ViewBufferObject& GetView() const
+    {
+        return m_view;
+    }
+
+    // The view is only uploaded to a frame's set when revision differs from the one it has.
+    void SetView(const ViewBufferObject& view, uint64_t revision)
+    {
+        m_view         = view;
+        m_viewRevision = revision;
     }
 
     void* GetCommandBuffer()
@@ -84,7 +199,10 @@ class Renderer
         m_device.SubmitTemporaryCommandBuffer(buffer);
     }
 
-    void CreateBuffer(
+    // Create a device buffer and fill it, never stalls rendering.
+    // Host visible device memory is written directly, anything else is queued for upload
+    // and skipped by draws until the returned future is ready.
+    std::shared_future<void> CreateBuffer(
         std::shared_ptr<Buffer>& buffer,
         BufferType               bufferType,
         void*                    data,
@@ -92,60 +210,190 @@ class Renderer
         uint32_t                 elementCount
     )
     {
-        auto hostBuffer =
-            std::make_shared<Buffer>(bufferType, HostBuffer, elementSize, elementCount);
-        auto deviceBuffer =
-            std::make_shared<Buffer>(bufferType, DeviceBuffer, elementSize, elementCount);
-        hostBuffer->Write(data, elementSize * elementCount);
-        auto tempBuffer = GetTemporaryCommandBuffer();
-        hostBuffer->CopyToDevice(tempBuffer, static_pointer_cast<Buffer>(deviceBuffer));
-        SubmitTemporaryCommandBuffer(tempBuffer);
-        buffer = static_pointer_cast<Buffer>(deviceBuffer);
+        buffer = std::make_shared<Buffer>(
+            bufferType,
+            DeviceBuffer,
+            elementSize,
+            elementCount,
+            m_uploadQueueFamilies,
+            HostWriteAccess
+        );
+
+        const auto size = static_cast<size_t>(elementSize) * elementCount;
+        if (buffer->IsHostVisible())
+        {
+            buffer->Write(data, size);
+
+            std::promise<void> written;
+            written.set_value();
+            return written.get_future().share();
+        }
+
+        return m_uploader->Upload(buffer, data, size);
+    }
+
+    // CreateBuffer for vertices, also computing their bounds for culling.
+    template<typename V>
+    std::shared_future<void> CreateVertexBuffer(
+        std::shared_ptr<Buffer>& buffer,
+        std::vector<V>&          vertices,
+        SBoundingSphere&         bounds
+    )
+    {
+        bounds = ComputeBoundingSphere(vertices);
+        return CreateBuffer(
+            buffer,
+            VertexBuffer,
+            vertices.data(),
+            sizeof(V),
+            static_cast<uint32_t>(vertices.size())
+        );
+    }
+
+    // Suballocate a mesh from the shared arena buffers, safe to call from any thread.
+    // Draws skip it until the upload finishes, the space is freed with the last handle.
+    template<typename V>
+    std::shared_ptr<SMeshAllocation> CreateMesh(
+        const std::vector<V>&     vertices,
+        const std::vector<Index>& indices
+    )
+    {
+        return m_meshArena->Create(vertices, indices);
     }
 
-    void DrawWithBuffers(std::shared_ptr<Buffer> vertexBuffer, std::shared_ptr<Buffer> indexBuffer)
+    // Pack the mesh arena at the start of the next frame, meshes in packed buffers
+    // aren't drawn until their copy finishes.
+    void RequestDefragment()
+    {
+        m_defragmentRequested = true;
+    }
+
+    // Draw instanceCount copies of an arena mesh,
+    // using the model matrices starting at firstInstance.
+    // Consecutive meshes of the same format share the bound buffers.
+    void DrawMesh(
+        std::shared_ptr<SMeshAllocation> mesh,
+        uint32_t                         instanceCount = 1,
+        uint32_t                         firstInstance = 0
+    )
     {
+        auto commandBuffer = m_device.GetCommandBuffer();
+        if (commandBuffer == nullptr || !m_meshArena->IsDrawable(*mesh))
+        {
+            return;
+        }
+
+        if (!BindMeshBuffers(commandBuffer, mesh->format))
+        {
+            return;
+        }
+
+        vkCmdDrawIndexed(
+            commandBuffer,
+            mesh->indexCount,
+            instanceCount,
+            mesh->firstIndex,
+            static_cast<int32_t>(mesh->vertexOffset),
+            firstInstance
+        );
+        m_drawCalls++;
+
+        // The ranges can't be handed out again while the GPU may still read them.
+        m_device.DeferRelease(mesh);
+    }
+
+    // Draw instanceCount copies of a mesh,
+    // using the model matrices starting at firstInstance.
+    void DrawWithBuffers(
+        std::shared_ptr<Buffer> vertexBuffer,
+        std::shared_ptr<Buffer> indexBuffer,
+        uint32_t                instanceCount = 1,
+        uint32_t                firstInstance = 0
+    )
+    {
+        if (!vertexBuffer->IsReady() || !indexBuffer->IsReady())
+        {
+            return;
+        }
+
         auto commandBuffer = GetCommandBuffer();
         if (commandBuffer != nullptr)
         {
             vertexBuffer->Bind(commandBuffer);
             indexBuffer->Bind(commandBuffer);
-            indexBuffer->Draw(commandBuffer);
-            m_frameBuffers.push_back(vertexBuffer);
-            m_frameBuffers.push_back(indexBuffer);
+            m_bufferBinds += 2;
+            m_boundMeshFormat.reset();
+            indexBuffer->Draw(commandBuffer, instanceCount, firstInstance);
+            m_drawCalls++;
+            m_device.DeferRelease(vertexBuffer);
+            m_device.DeferRelease(indexBuffer);
         }
     }
 
+    // Draw a list in order, long lists are split into slices that jobs on jobSystem
+    // record into secondary command buffers in parallel.
+    // Without a job system everything is recorded on the calling thread.
+    void DrawList(const std::vector<SDraw>& draws, JPH::JobSystem* jobSystem);
+
+    // Small per-draw data for the following draws, up to MaxPushConstantSize bytes.
+    // Goes to the pipeline last bound with BindPipeline.
+    void PushConstants(const void* data, uint32_t size);
+
+    // Per-draw data for the following draws, up to MaxDrawDataSize bytes,
+    // read from the dynamic uniform buffer at set 2 (PerObject) binding 1, see draw.glsl.
+    // Costs a copy into the frame's ring and a rebind of the per-object descriptor set,
+    // false if the ring is full.
+    bool SetDrawData(const void* data, uint32_t size);
+
+    // Skipped when the pipeline is already bound in the frame's command buffer.
     void BindPipeline(RenderPipeline pipe)
     {
-        auto commandBuffer = m_device.GetCommandBuffer();
-        auto currentFrame  = m_device.GetCurrentFrame();
+        if (pipe == m_boundPipeline)
+        {
+            return;
+        }
+
+        BindPipeline(m_device.GetCommandBuffer(), pipe);
+        m_boundPipeline = pipe;
+    }
+
+  private:
+    struct SCullBatch
+    {
+        RenderPipeline pipeline;
+        VertexFormat   format;
+        uint32_t       firstCommand;
+        uint32_t       objectCount;
+    };
+
+    void BindPipeline(VkCommandBuffer commandBuffer, RenderPipeline pipe)
+    {
+        auto currentFrame = m_device.GetCurrentFrame();
+        m_pipelineBinds++;
 
         switch (pipe)
         {
             case GEO_P_C:
             {
-                m_testPipeline->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentFrame);
+                BindPipeline(m_testPipeline, pipe, commandBuffer, currentFrame);
                 break;
             }
 
             case GEO_P_N_C:
             {
-                m_geoPNCPipeline
-                    ->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentFrame);
+                BindPipeline(m_geoPNCPipeline, pipe, commandBuffer, currentFrame);
                 break;
             }
 
             case FULLSCREEN:
             {
-                m_fullscreenPipeline
-                    ->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentFrame);
+                BindPipeline(m_fullscreenPipeline, pipe, commandBuffer, currentFrame);
                 break;
             }
 
             case SKY:
             {
-                m_skyPipeline->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentFrame);
+                BindPipeline(m_skyPipeline, pipe, commandBuffer, currentFrame);
                 break;
             }
 
@@ -156,8 +404,106 @@ class Renderer
         }
     }
 
-  private:
-    VkShaderModule& CreateShaderModule(VkShaderModuleCreateInfo createInfo);
+    template<typename F>
+    void VisitBoundPipeline(F&& visit)
+    {
+        switch (m_boundPipeline)
+        {
+            case GEO_P_C:
+            {
+                visit(*m_testPipeline);
+                break;
+            }
+
+            case GEO_P_N_C:
+            {
+                visit(*m_geoPNCPipeline);
+                break;
+            }
+
+            case FULLSCREEN:
+            {
+                visit(*m_fullscreenPipeline);
+                break;
+            }
+
+            case SKY:
+            {
+                visit(*m_skyPipeline);
+                break;
+            }
+
+            default:
+            {
+                throw std::runtime_error("No pipeline bound");
+            }
+        }
+    }
+
+    bool IsPipelineCreated(RenderPipeline pipe) const
+    {
+        switch (pipe)
+        {
+            case GEO_P_C:
+            {
+                return m_testPipeline != nullptr;
+            }
+
+            case GEO_P_N_C:
+            {
+                return m_geoPNCPipeline != nullptr;
+            }
+
+            case FULLSCREEN:
+            {
+                return m_fullscreenPipeline != nullptr;
+            }
+
+            case SKY:
+            {
+                return m_skyPipeline != nullptr;
+            }
+
+            default:
+            {
+                throw std::runtime_error("unknown pipeline");
+            }
+        }
+    }
+
+    // Record draws[begin, end) and return how many were recorded.
+    // Only reads renderer state, so slices can be recorded concurrently.
+    uint32_t RecordDraws(
+        VkCommandBuffer           commandBuffer,
+        const std::vector<SDraw>& draws,
+        size_t                    begin,
+        size_t                    end
+    );
+
+    // Bind the arena buffers of a format unless they already are, false if there are none.
+    bool BindMeshBuffers(VkCommandBuffer commandBuffer, VertexFormat format);
+
+    // Lazy pipelines are created here the first time they are bound, on the render thread.
+    template<typename V>
+    void BindPipeline(
+        std::shared_ptr<Pipeline<V>>& pipeline,
+        RenderPipeline                pipe,
+        VkCommandBuffer               commandBuffer,
+        uint32_t                      frameIndex
+    )
+    {
+        if (pipeline == nullptr)
+        {
+            CreatePipeline(pipe);
+        }
+        pipeline->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, frameIndex);
+    }
+
+    // Build a pipeline from its entry in m_pipelineDescs, safe to run concurrently
+    // for different pipelines.
+    void CreatePipeline(RenderPipeline pipeline);
+
+    VkShaderModule CreateShaderModule(VkShaderModuleCreateInfo createInfo);
     constexpr VkPipelineShaderStageCreateInfo FillShaderStageCreateInfo(
         VkShaderModule&       module,
         VkShaderStageFlagBits stage
@@ -166,18 +512,41 @@ class Renderer
     Instance m_instance;
     Device   m_device;
 
+    std::unique_ptr<Uploader> m_uploader;
+    // Device buffers are shared between the graphics and transfer queues.
+    std::vector<uint32_t> m_uploadQueueFamilies;
+
+    std::shared_ptr<MeshArena> m_meshArena;
+    // Format of the arena buffers and the pipeline bound in the current command buffer.
+    std::optional<VertexFormat> m_boundMeshFormat;
+    RenderPipeline              m_boundPipeline = RenderPipeline::INVALID;
+    std::atomic<bool>           m_defragmentRequested = false;
+
     std::shared_ptr<DescriptorSet> m_descriptorSet;
     std::vector<VkShaderModule>    m_vkShaderModules;
+    std::mutex                     m_shaderModuleMutex;
+    std::vector<SPipelineDesc>     m_pipelineDescs;
 
     std::shared_ptr<Pipeline<Vertex_P_C>>   m_testPipeline;
     std::shared_ptr<Pipeline<Vertex_P_N_C>> m_geoPNCPipeline;
     std::shared_ptr<Pipeline<VertexEmpty>>  m_fullscreenPipeline;
     std::shared_ptr<Pipeline<Vertex_P>>     m_skyPipeline;
 
-    std::shared_ptr<UniformBufferObject> m_ubo;
+    std::unique_ptr<ComputePipeline> m_cullPipeline;
+    std::vector<SCullObject>         m_cullObjects;
+    std::vector<SCullBatch>          m_cullBatches;
+
+    std::shared_ptr<FrameBufferObject> m_frameUbo;
+    ViewBufferObject                   m_view {};
+    uint64_t                           m_viewRevision = 0;
+
+    uint32_t m_drawCalls        = 0;
+    uint32_t m_visibleObjects   = 0;
+    uint32_t m_culledObjects    = 0;
+    uint32_t m_gpuCulledObjects = 0;
 
-    // Hold so we don't call Buffer destructor
-    // while still in use by command buffer.
-    std::vector<std::shared_ptr<Buffer>> m_frameBuffers;
+    // Also counted by the threads recording DrawList slices.
+    std::atomic<uint32_t> m_pipelineBinds = 0;
+    std::atomic<uint32_t> m_bufferBinds   = 0;
 };
 } // namespace legs
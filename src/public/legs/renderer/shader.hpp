@@ -3,6 +3,7 @@
 #include <vulkan/vulkan_core.h>
 
 // Generated files by glslang
+#include <cull_comp.h>
 #include <fullscreen_frag.h>
 #include <fullscreen_vert.h>
 #include <lit_pnc_vert.h>
@@ -14,13 +14,20 @@
 
 namespace legs
 {
-struct UniformBufferObject
+// Set 0, written once per frame.
+struct FrameBufferObject
+{
+    alignas(16) glm::vec3 sunDir;
+    alignas(16) glm::vec3 sunColor;
+};
+
+// Set 1, only written when the view changes. Per-object data lives in set 2,
+// the model matrix storage buffer and per-draw data.
+struct ViewBufferObject
 {
-    alignas(16) glm::mat4 model;
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
-    alignas(16) glm::mat4 mvp;
-    alignas(16) glm::mat4 invModel;
+    alignas(16) glm::mat4 viewProj;
     alignas(16) glm::mat4 invView;
     alignas(16) glm::mat4 invProj;
     alignas(16) glm::mat4 clipToWorld;
@@ -28,19 +35,14 @@ struct UniformBufferObject
 
     alignas(16) glm::vec4 viewport;
 
-    alignas(16) glm::vec3 sunDir;
-    alignas(16) glm::vec3 sunColor;
-
     void SetCamera(const std::shared_ptr<Camera> cam)
     {
-        model       = glm::identity<glm::mat4>();
         view        = cam->view;
         proj        = cam->proj;
-        mvp         = proj * view * model;
-        invModel    = glm::inverse(model);
+        viewProj    = proj * view;
         invView     = glm::inverse(view);
         invProj     = glm::inverse(proj);
-        clipToWorld = glm::inverse(proj * view);
+        clipToWorld = glm::inverse(viewProj);
         eye         = cam->GetPosition();
 
         viewport = cam->viewport;
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include <legs/renderer/buffer.hpp>
+#include <legs/renderer/device.hpp>
+
+namespace legs
+{
+// Streams data into device buffers through a persistently mapped staging ring
+// on the transfer queue. Copies staged between flushes go out in a single submit
+// with one fence, finished submits are retired by Poll which frees their ring space.
+class Uploader
+{
+  public:
+    Uploader() = delete;
+    Uploader(Device& device, size_t ringSize);
+    ~Uploader();
+
+    Uploader(const Uploader&)            = delete;
+    Uploader(Uploader&&)                 = delete;
+    Uploader& operator=(const Uploader&) = delete;
+    Uploader& operator=(Uploader&&)      = delete;
+
+    // Stage a copy into a device buffer, safe to call from any thread.
+    // The data is copied out right away, the buffer is ready once the future is.
+    std::shared_future<void> Upload(
+        std::shared_ptr<Buffer> destination,
+        const void*             data,
+        size_t                  size,
+        size_t                  destinationOffset = 0
+    );
+
+    // Copy between device buffers, ordered after every upload staged before it
+    // and before every upload staged after it.
+    std::shared_future<void> Copy(
+        std::shared_ptr<Buffer>          source,
+        std::shared_ptr<Buffer>          destination,
+        const std::vector<VkBufferCopy>& regions
+    );
+
+    // Submit everything staged since the last flush.
+    void Flush();
+
+    // Retire submits the GPU has finished, never blocks.
+    void Poll();
+
+    // Submit and wait for every upload so far.
+    void WaitIdle();
+
+  private:
+    struct SBatch
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence         fence         = VK_NULL_HANDLE;
+
+        // Ring space taken, including what was skipped when wrapping around.
+        size_t ringBytes = 0;
+
+        std::vector<std::shared_ptr<Buffer>> destinations;
+        std::vector<std::shared_ptr<Buffer>> sources;
+        // Staging for uploads that don't fit in the ring at all.
+        std::vector<std::unique_ptr<Buffer>> oversized;
+
+        std::promise<void>       done;
+        std::shared_future<void> future;
+    };
+
+    void BeginBatch();
+    bool TryAllocate(size_t size, size_t& offset, size_t& consumed);
+    void SubmitLocked();
+    void RetireLocked(bool waitOldest);
+
+    Device&       m_device;
+    VkCommandPool m_vkCommandPool;
+
+    std::mutex m_mutex;
+
+    std::unique_ptr<Buffer> m_ring;
+    uint8_t*                m_ringMemory = nullptr;
+    const size_t            m_ringSize;
+    size_t                  m_ringHead = 0;
+    size_t                  m_ringUsed = 0;
+
+    // Batches are retired in submit order, which is also the order they took ring space in.
+    std::unique_ptr<SBatch>              m_recording;
+    std::deque<std::unique_ptr<SBatch>>  m_inFlight;
+    std::vector<std::unique_ptr<SBatch>> m_freeBatches;
+};
+} // namespace legs
@@ -0,0 +1,11 @@
+// Per-draw data set with Renderer::SetDrawData, sized to MaxDrawDataSize.
+layout(std140, set = 2, binding = 1) uniform DrawData
+{
+    vec4 data[16];
+} drawData;
+
+// Per-draw data pushed with Renderer::PushConstants, sized to MaxPushConstantSize.
+layout(push_constant) uniform DrawConstants
+{
+    vec4 data[8];
+} drawConstants;
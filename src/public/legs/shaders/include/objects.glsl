@@ -0,0 +1,5 @@
+// Model matrices of everything drawn this frame, indexed by instance.
+layout(std430, set = 2, binding = 0) readonly buffer ObjectBuffer
+{
+    mat4 models[];
+} objects;
@@ -1,17 +1,20 @@
-layout(binding = 0) uniform UniformBufferObject
+// Set 0: changes once per frame.
+layout(set = 0, binding = 0) uniform FrameUniforms
+{
+    vec3 sunDir;
+    vec3 sunColor;
+} frame;
+
+// Set 1: changes with the view, only rewritten when the camera moves.
+layout(set = 1, binding = 0) uniform ViewUniforms
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
-    mat4 mvp;
-    mat4 invModel;
+    mat4 viewProj;
     mat4 invView;
     mat4 invProj;
     mat4 clipToWorld;
     vec3 eye;
 
     vec4 viewport;
-
-    vec3 sunDir;
-    vec3 sunColor;
-} ubo;
+} camera;
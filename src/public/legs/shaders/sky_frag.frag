@@ -11,18 +11,18 @@ layout(location = 0) out vec4 outColor;
 
 void main()
 {
-    float sunDot = dot(fragDir, ubo.sunDir);
+    float sunDot = dot(fragDir, frame.sunDir);
 
     vec3 darkColor = vec3(0.05, 0.05, 0.05);
     vec3 baseColor = vec3(0.1, 0.2, 0.7);
     vec3 brightColor = vec3(1.0, 1.0, 1.0);
 
-    float dayAmount = 0.01 + smoothstep(-1.0, 1.0, ubo.sunDir.z);
+    float dayAmount = 0.01 + smoothstep(-1.0, 1.0, frame.sunDir.z);
     darkColor.rgb *= dayAmount;
     baseColor.rgb *= dayAmount;
     brightColor.rgb *= dayAmount;
 
-    float horizonAmount = 3.0 * smoothstep(0.9, -0.4, ubo.sunDir.z);
+    float horizonAmount = 3.0 * smoothstep(0.9, -0.4, frame.sunDir.z);
     vec3 horizonColor = 1.0 + vec3(horizonAmount, 0.0, -0.4 * horizonAmount);
     darkColor.rgb *= horizonColor;
     baseColor.rgb *= horizonColor;
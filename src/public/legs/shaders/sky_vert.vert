@@ -9,6 +9,6 @@ layout(location = 0) out vec3 fragDir;
 
 void main()
 {
-    fragDir = normalize((transpose(ubo.view) * vec4(inPosition, 1.0)).xyz);
-    gl_Position = ubo.proj * vec4(inPosition, 1.0);
+    fragDir = normalize((transpose(camera.view) * vec4(inPosition, 1.0)).xyz);
+    gl_Position = camera.proj * vec4(inPosition, 1.0);
 }
@@ -4,11 +4,12 @@
 
 #include "include/vertex_pc.glsl"
 #include "include/ubo.glsl"
+#include "include/objects.glsl"
 
 layout(location = 0) out vec3 fragColor;
 
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = camera.viewProj * objects.models[gl_InstanceIndex] * vec4(inPosition, 1.0);
     fragColor = inColor;
 }
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <legs/jolt_pch.hpp>
+
+#include <legs/isystem.hpp>
+
+namespace legs
+{
+enum class SystemPhase
+{
+    FRAME,
+    TICK,
+};
+
+struct SSystemTiming
+{
+    std::string name;
+    // Longest chain of systems this one has to wait for.
+    uint32_t level;
+    bool     exclusive;
+    size_t   reads;
+    size_t   writes;
+    double   lastTime;
+};
+
+// Runs OnFrame or OnTick of every system, ordered by a dependency graph
+// built from their declared access. Systems that conflict keep the order they
+// were added in, the rest run concurrently on the job system.
+class SystemScheduler
+{
+  public:
+    SystemScheduler() = delete;
+    SystemScheduler(SystemPhase phase);
+    ~SystemScheduler() = default;
+
+    SystemScheduler(const SystemScheduler&)            = delete;
+    SystemScheduler(SystemScheduler&&)                 = delete;
+    SystemScheduler& operator=(const SystemScheduler&) = delete;
+    SystemScheduler& operator=(SystemScheduler&&)      = delete;
+
+    void Add(std::shared_ptr<ISystem> system);
+
+    // Run every system once, serially on this thread if jobSystem is null.
+    void Run(JPH::JobSystem* jobSystem);
+
+    // Schedule and last run times for debug UI, safe to call from any thread.
+    std::vector<SSystemTiming> GetTimings() const;
+    double                     GetLastTime() const;
+
+  private:
+    struct SNode
+    {
+        std::shared_ptr<ISystem> system;
+        SystemAccess             access;
+        std::string              name;
+        std::vector<size_t>      dependents;
+        uint32_t                 dependencies = 0;
+        uint32_t                 level        = 0;
+    };
+
+    void Rebuild();
+    void RunNode(size_t index);
+    void RunGroup(size_t begin, size_t end, JPH::JobSystem* jobSystem);
+
+    const SystemPhase m_phase;
+
+    mutable std::mutex                    m_mutex;
+    std::vector<std::shared_ptr<ISystem>> m_pending;
+    bool                                  m_dirty = false;
+
+    // Only touched by the thread calling Run, and by GetTimings under m_mutex.
+    std::vector<SNode>                     m_nodes;
+    std::unique_ptr<std::atomic<double>[]> m_times;
+    std::atomic<double>                    m_lastTime = 0.0;
+    std::vector<JPH::JobHandle>            m_handles;
+};
+} // namespace legs
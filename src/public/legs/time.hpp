@@ -73,10 +73,28 @@ class Time
         startTime = Now();
     }
 
-    static void SetFrameRate(unsigned int fps)
+    // A rate of 0 would make the interval infinite,
+    // it is ignored and false returned instead.
+    static bool SetFrameRate(unsigned int fps)
     {
+        if (fps == 0)
+        {
+            return false;
+        }
         FrameRate     = fps;
         FrameInterval = 1.0 / fps;
+        return true;
+    }
+
+    static bool SetTickRate(unsigned int tps)
+    {
+        if (tps == 0)
+        {
+            return false;
+        }
+        TickRate     = tps;
+        TickInterval = 1.0 / tps;
+        return true;
     }
 
     static void StartRender()
@@ -96,8 +114,9 @@ class Time
     static inline unsigned int FrameRate     = 60;
     static inline double       FrameInterval = 1.0 / FrameRate;
 
-    static constexpr const unsigned int TickRate     = 60;
-    static constexpr const double       TickInterval = 1.0 / TickRate;
+    // Fixed simulation step, ticks always advance by exactly TickInterval.
+    static inline unsigned int TickRate     = 60;
+    static inline double       TickInterval = 1.0 / TickRate;
 
   private:
     static inline double prevFrame;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace legs
+{
+// Lock-free single writer, single reader triple buffer.
+// The writer always has a private slot to fill and the reader always sees the latest
+// complete slot, neither side ever waits for the other.
+template<typename T>
+class TripleBuffer
+{
+  public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&)            = delete;
+    TripleBuffer(TripleBuffer&&)                 = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(TripleBuffer&&)      = delete;
+
+    // Writer: slot to fill, contents are whatever was last written to it.
+    T& GetWriteBuffer()
+    {
+        return m_slots[m_writeIndex];
+    }
+
+    // Writer: make the write slot the latest one and take over the old middle slot.
+    void Publish()
+    {
+        const auto previous = m_middle.exchange(m_writeIndex | DirtyBit, std::memory_order_acq_rel);
+        m_writeIndex        = previous & IndexMask;
+    }
+
+    // Reader: latest published slot, stays valid until the next call.
+    const T& GetReadBuffer()
+    {
+        if (m_middle.load(std::memory_order_relaxed) & DirtyBit)
+        {
+            const auto previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+            m_readIndex         = previous & IndexMask;
+        }
+        return m_slots[m_readIndex];
+    }
+
+  private:
+    static constexpr uint8_t DirtyBit  = 0x4;
+    static constexpr uint8_t IndexMask = 0x3;
+
+    std::array<T, 3> m_slots {};
+
+    uint8_t              m_writeIndex = 0;
+    uint8_t              m_readIndex  = 1;
+    std::atomic<uint8_t> m_middle     = 2;
+};
+} // namespace legs
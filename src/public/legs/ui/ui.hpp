@@ -1,10 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <glm/vec2.hpp>
 
 #include <legs/renderer/renderer.hpp>
+#include <legs/system_scheduler.hpp>
 #include <legs/window/window.hpp>
 
 namespace legs
@@ -14,6 +16,7 @@ enum class UIWindow
 {
     DEBUG,
     DEMO,
+    SYSTEMS,
     MAX
 };
 
@@ -40,15 +43,29 @@ class UI
         m_state.showWindow[index] = !m_state.showWindow[index];
     }
 
+    void SetSystemSchedulers(const SystemScheduler* frame, const SystemScheduler* tick)
+    {
+        m_frameSystems = frame;
+        m_tickSystems  = tick;
+    }
+
+    // Render thread only, like Render.
+    void ProcessEvents(const std::vector<SDL_Event>& events);
+
     void Render();
 
   private:
     void DebugWindow();
     void DemoWindow();
+    void SystemsWindow();
+    void SystemsTable(const char* label, const SystemScheduler* scheduler);
 
     std::shared_ptr<Window>   m_window;
     std::shared_ptr<Renderer> m_renderer;
     ImGuiCreationInfo         m_info;
     UIState                   m_state;
+
+    const SystemScheduler* m_frameSystems = nullptr;
+    const SystemScheduler* m_tickSystems  = nullptr;
 };
 }; // namespace legs
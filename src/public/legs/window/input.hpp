@@ -21,6 +21,7 @@ enum Key : unsigned int
 
     KEY_WINDOW_DEBUG,
     KEY_WINDOW_DEMO,
+    KEY_WINDOW_SYSTEMS,
 
     KEY_MAX,
 };
@@ -56,6 +57,7 @@ class InputSettings
 
         m_sdlKeyMap[static_cast<unsigned int>(SDL_SCANCODE_F2)] = Key::KEY_WINDOW_DEBUG;
         m_sdlKeyMap[static_cast<unsigned int>(SDL_SCANCODE_F3)] = Key::KEY_WINDOW_DEMO;
+        m_sdlKeyMap[static_cast<unsigned int>(SDL_SCANCODE_F4)] = Key::KEY_WINDOW_SYSTEMS;
     }
 
     Key GetKeyFromSDL(unsigned int scan)
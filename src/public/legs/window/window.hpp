@@ -1,7 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
+#include <SDL_events.h>
 #include <SDL_syswm.h>
 #include <vulkan/vulkan_core.h>
 
@@ -19,7 +22,16 @@ class Window
     void SetMouseGrab(bool grab);
     bool IsMouseGrabbed();
 
-    void AggregateInput(WindowInput& input);
+    // Events are also appended to uiEvents, for the UI to process on the render thread.
+    void AggregateInput(WindowInput& input, std::vector<SDL_Event>& uiEvents);
+
+    // Whether the UI wanted keyboard and mouse input on its last frame,
+    // input it wants is not passed on to the engine.
+    void SetUICapture(bool keyboard, bool mouse)
+    {
+        m_uiCapturesKeyboard = keyboard;
+        m_uiCapturesMouse    = mouse;
+    }
 
     void GetFramebufferSize(int* width, int* height);
 
@@ -39,5 +51,8 @@ class Window
   private:
     SDL_Window*                    m_window;
     std::shared_ptr<InputSettings> m_inputSettings;
+
+    std::atomic<bool> m_uiCapturesKeyboard = false;
+    std::atomic<bool> m_uiCapturesMouse    = false;
 };
 } // namespace legs
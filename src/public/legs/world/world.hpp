@@ -2,11 +2,22 @@
 
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <legs/iphysics.hpp>
+#include <legs/triple_buffer.hpp>
 
+#include <legs/components/mesh.hpp>
+#include <legs/components/physics_body.hpp>
+#include <legs/components/velocity.hpp>
+#include <legs/ecs/command_buffer.hpp>
+#include <legs/ecs/registry.hpp>
+#include <legs/ecs/sparse_set.hpp>
 #include <legs/entity/mesh_entity.hpp>
 #include <legs/entity/sky.hpp>
+#include <legs/renderer/render_queue.hpp>
+#include <legs/world/world_snapshot.hpp>
 
 namespace legs
 {
@@ -24,11 +35,27 @@ class World
 
     void Frame();
     void Tick();
-    void Render();
+    void Render(double time);
 
+    // Legacy entities, ticked through virtual calls alongside the registry.
+    // Deferred like everything else recorded in GetCommands().
     void AddEntity(std::shared_ptr<Entity> entity);
     void RemoveEntity(std::shared_ptr<Entity> entity);
 
+    // Destroy a registry entity at the next sync point,
+    // removing its physics body if it has one.
+    void DestroyEntity(EntityId entity);
+
+    // Command buffer of the calling thread, applied at the start and end of every tick.
+    CommandBuffer& GetCommands();
+
+    // Direct access is for the tick thread only, i.e. systems' OnTick,
+    // everything else should go through GetCommands().
+    Registry& GetRegistry()
+    {
+        return m_registry;
+    }
+
     void SetSky(std::shared_ptr<Sky> sky)
     {
         m_sky = sky;
@@ -44,15 +71,78 @@ class World
         return m_physics;
     }
 
+    // Run OnTick of entities that are IsThreadSafe() in batches on the physics job system.
+    void SetParallelTick(bool enabled)
+    {
+        m_parallelTick = enabled;
+    }
+
+    bool GetParallelTick() const
+    {
+        return m_parallelTick;
+    }
+
   private:
+    void ApplyCommands();
+    void ApplyAddEntity(std::shared_ptr<Entity> entity);
+    void ApplyRemoveEntity(std::shared_ptr<Entity> entity);
+    void ApplyDestroyEntity(EntityId entity);
+
+    void TickEntities();
+    void SyncPhysicsBodies();
+    void IntegrateVelocities();
+    void PublishSnapshot();
+
+    // Held while applying commands and by the frame thread walking entities,
+    // the tick thread is the only writer so it iterates without it.
     std::mutex m_worldMutex;
 
     std::shared_ptr<Renderer> m_renderer;
 
-    std::vector<std::shared_ptr<Entity>> m_entities;
+    Registry m_registry;
+
+    // One per thread that has recorded commands, never removed.
+    // m_commandBufferOwners holds the thread of the buffer at the same index.
+    std::mutex                                  m_commandBuffersMutex;
+    std::vector<std::unique_ptr<CommandBuffer>> m_commandBuffers;
+    std::vector<std::thread::id>                m_commandBufferOwners;
+
+    // Scratch space for ApplyCommands, reused to keep allocations down.
+    std::vector<CommandBuffer::SCommands> m_applying;
+    std::vector<EntityId>                 m_despawns;
+
+    // Keyed by Entity::GetId(), so removal doesn't need to search.
+    SparseSet<std::shared_ptr<Entity>>     m_entities;
+    SparseSet<std::shared_ptr<MeshEntity>> m_meshEntities;
+
+    // Subsets of m_entities split by IsThreadSafe(), tick thread only.
+    SparseSet<std::shared_ptr<Entity>> m_serialTickEntities;
+    SparseSet<std::shared_ptr<Entity>> m_parallelTickEntities;
+    bool                               m_parallelTick = false;
+
+    // Written by the tick thread, read by the render thread.
+    TripleBuffer<SWorldSnapshot> m_snapshots;
+    uint64_t                     m_tickCount = 0;
+    double                       m_time      = 0.0;
+
+    // Snapshot objects sorted by mesh and their interpolated model matrices
+    // in the same order, render thread only.
+    std::vector<uint32_t>  m_renderOrder;
+    std::vector<glm::mat4> m_renderModels;
+    // Model matrix of every snapshot object drawn with its own buffers, by snapshot index.
+    std::vector<glm::mat4> m_objectModels;
+    // World space bounds of m_renderOrder before culling, and whether each one is visible.
+    std::vector<glm::vec4> m_cullSpheres;
+    std::vector<uint8_t>   m_cullVisible;
+    // One instanced draw per group of m_renderOrder.
+    std::vector<SDraw> m_draws;
+    RenderQueue        m_renderQueue;
 
     std::shared_ptr<Sky> m_sky;
 
     std::shared_ptr<IPhysics> m_physics;
+
+    // Tells worlds apart in per-thread command buffer lookups.
+    const uint64_t m_serial;
 };
 } // namespace legs
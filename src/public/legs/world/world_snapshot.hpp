@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <legs/components/transform.hpp>
+#include <legs/renderer/buffer.hpp>
+#include <legs/renderer/renderer.hpp>
+
+namespace legs
+{
+// Renderable state of one entity, copied out of the world at the end of a tick.
+struct SRenderObject
+{
+    STransform              transform;
+    STransform              previousTransform;
+    RenderPipeline          pipeline;
+    std::shared_ptr<Buffer> vertexBuffer;
+    std::shared_ptr<Buffer> indexBuffer;
+    // Arena mesh, drawn instead of the buffers when set.
+    std::shared_ptr<SMeshAllocation> mesh;
+    // Mesh space bounds for frustum culling, never culled without.
+    std::optional<SBoundingSphere> bounds;
+
+    // Transform between the previous and the current tick, alpha in [0, 1].
+    STransform GetInterpolatedTransform(float alpha) const
+    {
+        return STransform::Interpolate(previousTransform, transform, alpha);
+    }
+};
+
+// Everything the render thread needs from the world, published once per tick.
+struct SWorldSnapshot
+{
+    uint64_t                   tick = 0;
+    double                     time = 0.0;
+    std::vector<SRenderObject> objects;
+};
+} // namespace legs
@@ -2,17 +2,22 @@
 
 namespace legs
 {
+static std::atomic<uint32_t> nextBufferId = 0;
+
 Buffer::Buffer(
-    BufferType     bufferType,
-    BufferLocation bufferLocation,
-    uint32_t       elementSize,
-    uint32_t       elementCount
+    BufferType                   bufferType,
+    BufferLocation               bufferLocation,
+    uint32_t                     elementSize,
+    uint32_t                     elementCount,
+    const std::vector<uint32_t>& queueFamilies,
+    BufferHostAccess             hostAccess
 ) :
     m_bufferType(bufferType),
     m_bufferLocation(bufferLocation),
     m_elementSize(elementSize),
     m_elementCount(elementCount),
-    m_size(m_elementSize * m_elementCount)
+    m_size(m_elementSize * m_elementCount),
+    m_id(nextBufferId++)
 {
     VkBufferCreateInfo bufferInfo {};
     bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -20,6 +25,14 @@ Buffer::Buffer(
     bufferInfo.usage       = 0;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // Skips queue family ownership transfers between e.g. transfer and graphics queues.
+    if (queueFamilies.size() > 1)
+    {
+        bufferInfo.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        bufferInfo.pQueueFamilyIndices   = queueFamilies.data();
+    }
+
     VmaAllocationCreateInfo allocInfo {};
 
     switch (m_bufferType)
@@ -43,6 +56,33 @@ Buffer::Buffer(
             break;
         }
 
+        case StorageBuffer:
+        {
+            bufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            allocInfo.requiredFlags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            break;
+        }
+
+        case IndirectBuffer:
+        {
+            bufferInfo.usage |=
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            break;
+        }
+
+        case StagingBuffer:
+        {
+            // Only ever a copy source, which HostBuffer already covers.
+            break;
+        }
+
+        case ReadbackBuffer:
+        {
+            bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            allocInfo.requiredFlags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            break;
+        }
+
         default:
         {
             std::runtime_error("Unhandled buffer type");
@@ -55,8 +95,11 @@ Buffer::Buffer(
         {
             bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
+            // Read back buffers are read by the host instead, cached memory suits them best.
             allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
-            allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+            allocInfo.flags |= m_bufferType == ReadbackBuffer
+                                   ? VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+                                   : VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
             allocInfo.requiredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
             allocInfo.preferredFlags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
 
@@ -65,11 +108,22 @@ Buffer::Buffer(
 
         case DeviceBuffer:
         {
-            bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            // Source as well, for moving contents into a bigger buffer.
+            bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
             allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
             allocInfo.preferredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
+            // Let VMA hand out device local memory the host can also see (ReBAR, integrated GPUs),
+            // it stays persistently mapped and gets written directly instead of staged.
+            // Buffers only the GPU writes stay plain device local.
+            if (hostAccess == HostWriteAccess)
+            {
+                allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT
+                                   | VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT
+                                   | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+            }
+
             break;
         }
 
@@ -80,6 +134,10 @@ Buffer::Buffer(
     }
 
     vmaCreateBuffer(g_vma, &bufferInfo, &allocInfo, &m_vkBuffer, &m_vmaAllocation, nullptr);
+
+    VkMemoryPropertyFlags memoryFlags;
+    vmaGetAllocationMemoryProperties(g_vma, m_vmaAllocation, &memoryFlags);
+    m_isHostVisible = (memoryFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
 }
 
 Buffer::~Buffer()
@@ -91,9 +149,9 @@ Buffer::~Buffer()
     vmaDestroyBuffer(g_vma, m_vkBuffer, m_vmaAllocation);
 }
 
-void Buffer::Write(void* data, size_t size)
+void Buffer::Write(void* data, size_t size, size_t offset)
 {
-    vmaCopyMemoryToAllocation(g_vma, data, m_vmaAllocation, 0, size);
+    vmaCopyMemoryToAllocation(g_vma, data, m_vmaAllocation, offset, size);
 }
 
 void Buffer::CopyToDevice(void* commandBuffer, std::shared_ptr<Buffer> deviceBuffer)
@@ -180,7 +238,7 @@ void Buffer::Bind(void* commandBuffer)
     }
 }
 
-void Buffer::Draw(void* commandBuffer)
+void Buffer::Draw(void* commandBuffer, uint32_t instanceCount, uint32_t firstInstance)
 {
     auto vkCommandBuffer = static_cast<VkCommandBuffer>(commandBuffer);
 
@@ -188,13 +246,13 @@ void Buffer::Draw(void* commandBuffer)
     {
         case VertexBuffer:
         {
-            vkCmdDraw(vkCommandBuffer, m_elementCount, 1, 0, 0);
+            vkCmdDraw(vkCommandBuffer, m_elementCount, instanceCount, 0, firstInstance);
             break;
         }
 
         case IndexBuffer:
         {
-            vkCmdDrawIndexed(vkCommandBuffer, m_elementCount, 1, 0, 0, 0);
+            vkCmdDrawIndexed(vkCommandBuffer, m_elementCount, instanceCount, 0, 0, firstInstance);
             break;
         }
 
@@ -240,6 +298,12 @@ void Buffer::Map(void** data)
     m_isMapped = true;
 }
 
+void Buffer::Flush(size_t offset, size_t size)
+{
+    // No-op for host coherent memory.
+    vmaFlushAllocation(g_vma, m_vmaAllocation, offset, size);
+}
+
 void Buffer::Unmap()
 {
     if (!m_isMapped)
@@ -0,0 +1,93 @@
+#include <legs/log.hpp>
+#include <legs/renderer/common.hpp>
+#include <legs/renderer/compute_pipeline.hpp>
+
+namespace legs
+{
+ComputePipeline::ComputePipeline(
+    const Device&                   device,
+    std::shared_ptr<DescriptorSet>  descriptorSet,
+    VkPipelineShaderStageCreateInfo shaderStage,
+    uint32_t                        pushConstantSize
+) :
+    m_device(device),
+    m_descriptorSet(descriptorSet)
+{
+    LOG_DEBUG("Creating ComputePipeline");
+
+    auto descriptorSetLayouts = descriptorSet->GetLayouts();
+
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts    = descriptorSetLayouts.data();
+    if (pushConstantSize > 0)
+    {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+    }
+
+    VK_CHECK(
+        vkCreatePipelineLayout(
+            m_device.GetVkDevice(),
+            &pipelineLayoutInfo,
+            nullptr,
+            &m_vkPipelineLayout
+        ),
+        "Failed to create compute pipeline layout"
+    );
+
+    VkComputePipelineCreateInfo computeCreateInfo {};
+    computeCreateInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    computeCreateInfo.stage  = shaderStage;
+    computeCreateInfo.layout = m_vkPipelineLayout;
+
+    VK_CHECK(
+        vkCreateComputePipelines(
+            m_device.GetVkDevice(),
+            m_device.GetPipelineCache(),
+            1,
+            &computeCreateInfo,
+            nullptr,
+            &m_vkPipeline
+        ),
+        "Failed to create compute pipeline"
+    );
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    LOG_DEBUG("Destroying ComputePipeline");
+
+    vkDestroyPipeline(m_device.GetVkDevice(), m_vkPipeline, nullptr);
+    vkDestroyPipelineLayout(m_device.GetVkDevice(), m_vkPipelineLayout, nullptr);
+}
+
+void ComputePipeline::Bind(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vkPipeline);
+    m_descriptorSet->Bind(
+        commandBuffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_vkPipelineLayout,
+        frameIndex
+    );
+}
+
+void ComputePipeline::PushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size)
+{
+    vkCmdPushConstants(
+        commandBuffer,
+        m_vkPipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        size,
+        data
+    );
+}
+} // namespace legs
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <limits>
+
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+#include <legs/jolt_pch.hpp>
+
+#include <legs/renderer/culling.hpp>
+
+namespace legs
+{
+SFrustum SFrustum::FromViewProjection(const glm::mat4& viewProjection)
+{
+    // glm is column major, rows of the matrix are the columns of its transpose.
+    const auto m = glm::transpose(viewProjection);
+
+    SFrustum frustum;
+    frustum.planes = {
+        m[3] + m[0],
+        m[3] - m[0],
+        m[3] + m[1],
+        m[3] - m[1],
+        m[2],
+        m[3] - m[2],
+    };
+
+    for (auto& plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+glm::vec4 TransformBoundingSphere(const SBoundingSphere& bounds, const glm::mat4& model)
+{
+    const auto center = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+    const auto scale  = std::max(
+        {glm::length(glm::vec3(model[0])),
+         glm::length(glm::vec3(model[1])),
+         glm::length(glm::vec3(model[2]))}
+    );
+    return glm::vec4(center, bounds.radius * scale);
+}
+
+uint32_t CullSpheres(
+    const SFrustum&               frustum,
+    const std::vector<glm::vec4>& spheres,
+    std::vector<uint8_t>&         visible
+)
+{
+    visible.resize(spheres.size());
+
+    uint32_t visibleCount = 0;
+    for (size_t first = 0; first < spheres.size(); first += 4)
+    {
+        // One sphere per lane, lanes past the end get an infinite radius and are ignored.
+        const auto lanes = std::min<size_t>(4, spheres.size() - first);
+
+        std::array<glm::vec4, 4> lane;
+        lane.fill(glm::vec4(0.0f, 0.0f, 0.0f, std::numeric_limits<float>::infinity()));
+        std::copy_n(spheres.begin() + static_cast<std::ptrdiff_t>(first), lanes, lane.begin());
+
+        const auto x = JPH::Vec4(lane[0].x, lane[1].x, lane[2].x, lane[3].x);
+        const auto y = JPH::Vec4(lane[0].y, lane[1].y, lane[2].y, lane[3].y);
+        const auto z = JPH::Vec4(lane[0].z, lane[1].z, lane[2].z, lane[3].z);
+        const auto r = -JPH::Vec4(lane[0].w, lane[1].w, lane[2].w, lane[3].w);
+
+        auto inside = JPH::UVec4::sReplicate(0xffffffff);
+        for (const auto& plane : frustum.planes)
+        {
+            const auto distance = x * plane.x + y * plane.y + z * plane.z
+                                  + JPH::Vec4::sReplicate(plane.w);
+            inside = JPH::UVec4::sAnd(inside, JPH::Vec4::sGreaterOrEqual(distance, r));
+        }
+
+        const auto mask = inside.GetTrues();
+        for (size_t i = 0; i < lanes; i++)
+        {
+            visible[first + i] = ((mask >> i) & 1) != 0;
+            if (visible[first + i])
+            {
+                visibleCount++;
+            }
+        }
+    }
+    return visibleCount;
+}
+} // namespace legs
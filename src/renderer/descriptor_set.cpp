@@ -1,5 +1,7 @@
+#include <bit>
 #include <cstdint>
 #include <cstring>
+#include <stdexcept>
 
 #include <legs/renderer/common.hpp>
 #include <legs/renderer/descriptor_set.hpp>
@@ -8,81 +10,135 @@
 
 namespace legs
 {
-DescriptorSet::DescriptorSet(
-    const Device&                        device,
-    std::vector<std::shared_ptr<Buffer>> uboBuffers
-) :
-    m_device(device),
-    m_uniformBuffers(uboBuffers)
+// Objects each frame's storage buffers start with room for.
+static constexpr uint32_t InitialObjectCapacity = 1024;
+// Pipeline and vertex format combinations drawn with culling.
+static constexpr uint32_t InitialBatchCapacity = 16;
+// Per-draw data each frame has room for, at least 4096 draws of the largest size.
+static constexpr uint32_t DrawDataRingSize = 1024 * 1024;
+
+static VkDescriptorSetLayoutBinding MakeBinding(
+    uint32_t           binding,
+    VkDescriptorType   type,
+    VkShaderStageFlags stages
+)
 {
-    VkDescriptorSetLayoutBinding uboBinding {};
-    uboBinding.binding            = 0;
-    uboBinding.descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboBinding.descriptorCount    = 1;
-    uboBinding.stageFlags         = VK_SHADER_STAGE_VERTEX_BIT;
-    uboBinding.pImmutableSamplers = nullptr;
+    VkDescriptorSetLayoutBinding layoutBinding {};
+    layoutBinding.binding            = binding;
+    layoutBinding.descriptorType     = type;
+    layoutBinding.descriptorCount    = 1;
+    layoutBinding.stageFlags         = stages;
+    layoutBinding.pImmutableSamplers = nullptr;
+    return layoutBinding;
+}
 
-    VkDescriptorSetLayoutCreateInfo layoutInfo {};
-    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings    = &uboBinding;
+DescriptorSet::DescriptorSet(const Device& device, uint32_t maxFramesInFlight) : m_device(device)
+{
+    const VkShaderStageFlags graphics = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    const VkShaderStageFlags compute  = VK_SHADER_STAGE_COMPUTE_BIT;
+    const VkDescriptorType   storage  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 
-    const auto maxFrames = static_cast<uint32_t>(m_uniformBuffers.size());
-    m_vkLayouts.resize(maxFrames);
+    m_vkLayouts.resize(DescriptorFrequencyCount);
 
-    for (uint32_t i = 0; i < maxFrames; i++)
+    // 0: frame uniforms, 1: objects to cull, 2: indirect draws, 3: draw counts.
+    CreateLayout(
+        PerFrame,
+        {
+            MakeBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, graphics),
+            MakeBinding(1, storage, compute),
+            MakeBinding(2, storage, compute),
+            MakeBinding(3, storage, compute),
+        }
+    );
+
+    // 0: view uniforms, culling needs the camera too.
+    CreateLayout(PerView, {MakeBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, graphics | compute)});
+
+    // 0: model matrices, also read by culling, 1: per-draw data.
+    CreateLayout(
+        PerObject,
+        {
+            MakeBinding(0, storage, VK_SHADER_STAGE_VERTEX_BIT | compute),
+            MakeBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, graphics),
+        }
+    );
+
+    m_vkSets.resize(maxFramesInFlight);
+
+    for (auto& sets : m_vkSets)
     {
+        VkDescriptorSetAllocateInfo allocInfo {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool     = device.GetUboDescriptorPool();
+        allocInfo.descriptorSetCount = DescriptorFrequencyCount;
+        allocInfo.pSetLayouts        = m_vkLayouts.data();
+
         VK_CHECK(
-            vkCreateDescriptorSetLayout(
-                device.GetVkDevice(),
-                &layoutInfo,
-                nullptr,
-                &m_vkLayouts[i]
-            ),
-            "Failed to create descriptor set layout"
+            vkAllocateDescriptorSets(device.GetVkDevice(), &allocInfo, sets.data()),
+            "Failed to allocate descriptor sets"
         );
     }
 
-    m_vkSets.resize(maxFrames);
+    m_frameBuffers.resize(maxFramesInFlight);
+    m_frameMappedMemory.resize(maxFramesInFlight);
+    m_viewBuffers.resize(maxFramesInFlight);
+    m_viewMappedMemory.resize(maxFramesInFlight);
+    m_viewRevisions.resize(maxFramesInFlight);
+    m_objectBuffers.resize(maxFramesInFlight);
+    m_objectsMappedMemory.resize(maxFramesInFlight);
+    m_cullBuffers.resize(maxFramesInFlight);
+    m_cullMappedMemory.resize(maxFramesInFlight);
+    m_drawCommandBuffers.resize(maxFramesInFlight);
+    m_drawCountBuffers.resize(maxFramesInFlight);
+    m_drawDataBuffers.resize(maxFramesInFlight);
+    m_drawDataMappedMemory.resize(maxFramesInFlight);
+    m_drawDataOffsets.resize(maxFramesInFlight);
 
-    VkDescriptorSetAllocateInfo allocInfo {};
-    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool     = device.GetUboDescriptorPool();
-    allocInfo.descriptorSetCount = maxFrames;
-    allocInfo.pSetLayouts        = m_vkLayouts.data();
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(device.GetVkPhysicalDevice(), &properties);
+    m_drawDataAlignment =
+        static_cast<uint32_t>(properties.limits.minUniformBufferOffsetAlignment);
 
-    VK_CHECK(
-        vkAllocateDescriptorSets(device.GetVkDevice(), &allocInfo, m_vkSets.data()),
-        "Failed to allocate descriptor sets"
-    );
-
-    m_ubosMappedMemory.resize(maxFrames);
-    for (uint32_t i = 0; i < maxFrames; i++)
+    for (uint32_t i = 0; i < maxFramesInFlight; i++)
     {
-        auto uniformBuffer = uboBuffers[i];
-        uniformBuffer->Map(&m_ubosMappedMemory[i]);
-
-        VkDescriptorBufferInfo bufferInfo {};
-        bufferInfo.buffer = uniformBuffer->GetVkBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range  = VK_WHOLE_SIZE;
-
-        VkWriteDescriptorSet descriptorWrite {};
-        descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet          = m_vkSets[i];
-        descriptorWrite.dstBinding      = 0;
-        descriptorWrite.dstArrayElement = 0;
-        descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrite.descriptorCount = 1;
-        descriptorWrite.pBufferInfo     = &bufferInfo;
-
-        vkUpdateDescriptorSets(m_device.GetVkDevice(), 1, &descriptorWrite, 0, nullptr);
+        m_frameBuffers[i] =
+            std::make_shared<Buffer>(UniformBuffer, HostBuffer, sizeof(FrameBufferObject), 1);
+        m_frameBuffers[i]->Map(&m_frameMappedMemory[i]);
+        WriteDescriptor(i, PerFrame, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_frameBuffers[i]);
+
+        m_viewBuffers[i] =
+            std::make_shared<Buffer>(UniformBuffer, HostBuffer, sizeof(ViewBufferObject), 1);
+        m_viewBuffers[i]->Map(&m_viewMappedMemory[i]);
+        WriteDescriptor(i, PerView, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_viewBuffers[i]);
+
+        CreateObjectBuffer(i, InitialObjectCapacity);
+        CreateCullBuffers(i, InitialObjectCapacity);
+        CreateDrawCountBuffer(i, InitialBatchCapacity);
+
+        // Never grown, draws past the end of the ring go without their data.
+        m_drawDataBuffers[i] =
+            std::make_shared<Buffer>(UniformBuffer, HostBuffer, 1, DrawDataRingSize);
+        m_drawDataBuffers[i]->Map(&m_drawDataMappedMemory[i]);
+        WriteDescriptor(
+            i,
+            PerObject,
+            1,
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+            m_drawDataBuffers[i],
+            MaxDrawDataSize
+        );
     }
 }
 
 DescriptorSet::~DescriptorSet()
 {
-    m_uniformBuffers.clear();
+    m_frameBuffers.clear();
+    m_viewBuffers.clear();
+    m_objectBuffers.clear();
+    m_cullBuffers.clear();
+    m_drawCommandBuffers.clear();
+    m_drawCountBuffers.clear();
+    m_drawDataBuffers.clear();
 
     for (auto& layout : m_vkLayouts)
     {
@@ -90,27 +146,223 @@ DescriptorSet::~DescriptorSet()
     }
 }
 
-void DescriptorSet::UpdateUBO(uint32_t frameIndex, const std::shared_ptr<UniformBufferObject> ubo)
+void DescriptorSet::UpdateFrameUBO(uint32_t frameIndex, const FrameBufferObject& ubo)
+{
+    std::memcpy(m_frameMappedMemory[frameIndex], &ubo, sizeof(FrameBufferObject));
+}
+
+void DescriptorSet::UpdateViewUBO(
+    uint32_t                frameIndex,
+    const ViewBufferObject& ubo,
+    uint64_t                revision
+)
+{
+    // Each frame in flight has its own copy, so a still camera stops costing
+    // anything once every frame has caught up.
+    if (revision != 0 && m_viewRevisions[frameIndex] == revision)
+    {
+        return;
+    }
+
+    std::memcpy(m_viewMappedMemory[frameIndex], &ubo, sizeof(ViewBufferObject));
+    m_viewRevisions[frameIndex] = revision;
+}
+
+void DescriptorSet::UpdateObjects(uint32_t frameIndex, const std::vector<glm::mat4>& models)
 {
-    std::memcpy(m_ubosMappedMemory[frameIndex], ubo.get(), sizeof(UniformBufferObject));
+    const auto capacity = m_objectBuffers[frameIndex]->GetElementCount();
+    if (models.size() > capacity)
+    {
+        // The frame's previous buffer is no longer in use,
+        // its fence was waited on before recording started.
+        CreateObjectBuffer(frameIndex, std::bit_ceil(static_cast<uint32_t>(models.size())));
+    }
+
+    std::memcpy(
+        m_objectsMappedMemory[frameIndex],
+        models.data(),
+        models.size() * sizeof(glm::mat4)
+    );
+}
+
+void DescriptorSet::UpdateCullObjects(
+    uint32_t                        frameIndex,
+    const std::vector<SCullObject>& objects,
+    uint32_t                        batchCount
+)
+{
+    // Same as the model matrices, the frame's previous buffers are no longer in use.
+    if (objects.size() > m_cullBuffers[frameIndex]->GetElementCount())
+    {
+        CreateCullBuffers(frameIndex, std::bit_ceil(static_cast<uint32_t>(objects.size())));
+    }
+
+    if (batchCount > m_drawCountBuffers[frameIndex]->GetElementCount())
+    {
+        CreateDrawCountBuffer(frameIndex, std::bit_ceil(batchCount));
+    }
+
+    std::memcpy(
+        m_cullMappedMemory[frameIndex],
+        objects.data(),
+        objects.size() * sizeof(SCullObject)
+    );
+}
+
+std::optional<uint32_t> DescriptorSet::WriteDrawData(
+    uint32_t    frameIndex,
+    const void* data,
+    uint32_t    size
+)
+{
+    if (size > MaxDrawDataSize)
+    {
+        throw std::runtime_error("Tried to write more draw data than a draw can read");
+    }
+
+    // Offsets are aligned the way dynamic uniform offsets have to be.
+    auto&      offset    = m_drawDataOffsets[frameIndex];
+    const auto alignment = m_drawDataAlignment;
+    const auto start     = (offset + alignment - 1) / alignment * alignment;
+    if (start + MaxDrawDataSize > DrawDataRingSize)
+    {
+        return std::nullopt;
+    }
+
+    std::memcpy(static_cast<uint8_t*>(m_drawDataMappedMemory[frameIndex]) + start, data, size);
+    offset = start + size;
+    return start;
 }
 
 void DescriptorSet::Bind(
     VkCommandBuffer     commandBuffer,
     VkPipelineBindPoint bindPoint,
     VkPipelineLayout    pipelineLayout,
-    uint32_t            frameIndex
+    uint32_t            frameIndex,
+    uint32_t            drawDataOffset
 )
 {
     vkCmdBindDescriptorSets(
         commandBuffer,
         bindPoint,
         pipelineLayout,
-        0,
+        PerFrame,
+        DescriptorFrequencyCount,
+        m_vkSets[frameIndex].data(),
         1,
-        &m_vkSets[frameIndex],
-        0,
-        nullptr
+        &drawDataOffset
     );
 }
+
+void DescriptorSet::BindObjects(
+    VkCommandBuffer     commandBuffer,
+    VkPipelineBindPoint bindPoint,
+    VkPipelineLayout    pipelineLayout,
+    uint32_t            frameIndex,
+    uint32_t            drawDataOffset
+)
+{
+    vkCmdBindDescriptorSets(
+        commandBuffer,
+        bindPoint,
+        pipelineLayout,
+        PerObject,
+        1,
+        &m_vkSets[frameIndex][static_cast<size_t>(PerObject)],
+        1,
+        &drawDataOffset
+    );
+}
+
+void DescriptorSet::CreateObjectBuffer(uint32_t frameIndex, uint32_t capacity)
+{
+    auto objectBuffer =
+        std::make_shared<Buffer>(StorageBuffer, HostBuffer, sizeof(glm::mat4), capacity);
+    objectBuffer->Map(&m_objectsMappedMemory[frameIndex]);
+    m_objectBuffers[frameIndex] = objectBuffer;
+
+    WriteDescriptor(frameIndex, PerObject, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, objectBuffer);
+}
+
+void DescriptorSet::CreateCullBuffers(uint32_t frameIndex, uint32_t capacity)
+{
+    auto cullBuffer =
+        std::make_shared<Buffer>(StorageBuffer, HostBuffer, sizeof(SCullObject), capacity);
+    cullBuffer->Map(&m_cullMappedMemory[frameIndex]);
+    m_cullBuffers[frameIndex] = cullBuffer;
+
+    // Only ever written by the culling shader.
+    auto drawCommandBuffer = std::make_shared<Buffer>(
+        IndirectBuffer,
+        DeviceBuffer,
+        sizeof(VkDrawIndexedIndirectCommand),
+        capacity
+    );
+    m_drawCommandBuffers[frameIndex] = drawCommandBuffer;
+
+    WriteDescriptor(frameIndex, PerFrame, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, cullBuffer);
+    WriteDescriptor(
+        frameIndex,
+        PerFrame,
+        2,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        drawCommandBuffer
+    );
+}
+
+void DescriptorSet::CreateDrawCountBuffer(uint32_t frameIndex, uint32_t capacity)
+{
+    auto drawCountBuffer =
+        std::make_shared<Buffer>(IndirectBuffer, DeviceBuffer, sizeof(uint32_t), capacity);
+    m_drawCountBuffers[frameIndex] = drawCountBuffer;
+
+    WriteDescriptor(frameIndex, PerFrame, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, drawCountBuffer);
+}
+
+void DescriptorSet::CreateLayout(
+    DescriptorFrequency                              frequency,
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings
+)
+{
+    VkDescriptorSetLayoutCreateInfo layoutInfo {};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings    = bindings.data();
+
+    VK_CHECK(
+        vkCreateDescriptorSetLayout(
+            m_device.GetVkDevice(),
+            &layoutInfo,
+            nullptr,
+            &m_vkLayouts[static_cast<size_t>(frequency)]
+        ),
+        "Failed to create descriptor set layout"
+    );
+}
+
+void DescriptorSet::WriteDescriptor(
+    uint32_t                       frameIndex,
+    DescriptorFrequency            frequency,
+    uint32_t                       binding,
+    VkDescriptorType               type,
+    const std::shared_ptr<Buffer>& buffer,
+    VkDeviceSize                   range
+)
+{
+    VkDescriptorBufferInfo bufferInfo {};
+    bufferInfo.buffer = buffer->GetVkBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range  = range;
+
+    VkWriteDescriptorSet descriptorWrite {};
+    descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet          = m_vkSets[frameIndex][static_cast<size_t>(frequency)];
+    descriptorWrite.dstBinding      = binding;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType  = type;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo     = &bufferInfo;
+
+    vkUpdateDescriptorSets(m_device.GetVkDevice(), 1, &descriptorWrite, 0, nullptr);
+}
 } // namespace legs
@@ -1,5 +1,9 @@
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <limits>
 #include <set>
 #include <stdexcept>
@@ -11,8 +15,23 @@
 #include <legs/renderer/common.hpp>
 #include <legs/renderer/device.hpp>
 
+#define PIPELINE_CACHE_PATH "pipeline_cache.bin"
+
 namespace legs
 {
+// Written in front of the cache data, a cache from another device or driver is discarded.
+struct SPipelineCacheHeader
+{
+    uint32_t magic;
+    uint32_t dataSize;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t  uuid[VK_UUID_SIZE];
+};
+
+static constexpr uint32_t PipelineCacheMagic = 0x4c504348; // "LPCH"
+
 constexpr static void _vkCmdBeginRenderingKHR(
     VkInstance             instance,
     VkCommandBuffer        commandBuffer,
@@ -44,23 +63,40 @@ constexpr static void _vkCmdEndRenderingKHR(VkInstance instance, VkCommandBuffer
     }
 }
 
-Device::Device(const Instance& instance, uint32_t maxFramesInFlight) :
+Device::Device(
+    const Instance& instance,
+    uint32_t        maxFramesInFlight,
+    uint32_t        recorderCount,
+    VkExtent2D      offscreenExtent
+) :
     m_instance(instance),
+    m_vkSwapchainExtent(offscreenExtent),
+    m_recorderCount(recorderCount),
     m_maxFramesInFlight(maxFramesInFlight)
 {
     LOG_INFO("Creating Device");
 
+    if (IsOffscreen() && (offscreenExtent.width == 0 || offscreenExtent.height == 0))
+    {
+        throw std::runtime_error("Tried rendering offscreen without a size");
+    }
+
     PickPhysicalDevice();
     CreateLogicalDevice();
 
     CreateAllocator(m_instance.GetVkInstance(), m_vkPhysicalDevice, m_vkDevice);
 
+    CreatePipelineCache();
     CreateSwapchain();
     CreateImageViews();
     CreateCommandPool();
     CreateCommandBuffers();
+    CreateRecorders();
     CreateSyncObjects();
     CreateDescriptorPools();
+
+    m_releaseQueues.resize(m_maxFramesInFlight);
+    m_readbacks.resize(m_maxFramesInFlight);
 }
 
 Device::~Device()
@@ -69,6 +105,9 @@ Device::~Device()
 
     vkDeviceWaitIdle(m_vkDevice);
 
+    m_releaseQueues.clear();
+    m_readbacks.clear();
+
     vkDestroyDescriptorPool(m_vkDevice, m_vkUboDescriptorPool, nullptr);
     vkDestroyDescriptorPool(m_vkDevice, m_vkImGuiDescriptorPool, nullptr);
 
@@ -86,6 +125,16 @@ Device::~Device()
     }
 
     vkDestroyCommandPool(m_vkDevice, m_vkCommandPool, nullptr);
+    for (auto& pools : m_vkRecorderPools)
+    {
+        for (auto& pool : pools)
+        {
+            vkDestroyCommandPool(m_vkDevice, pool, nullptr);
+        }
+    }
+
+    SavePipelineCache();
+    vkDestroyPipelineCache(m_vkDevice, m_vkPipelineCache, nullptr);
 
     DestroySwapchain();
 
@@ -101,23 +150,34 @@ void Device::Begin()
         "Failed waiting for in flight fence"
     );
 
-    auto imageResult = vkAcquireNextImageKHR(
-        m_vkDevice,
-        m_vkSwapchain,
-        UINT64_MAX,
-        m_vkImageSemaphores[m_currentFrame],
-        VK_NULL_HANDLE,
-        &m_currentImageIndex
-    );
-    if (imageResult == VK_ERROR_OUT_OF_DATE_KHR)
+    // Everything the frame's last submit used is free to go now.
+    m_releaseQueues[m_currentFrame].clear();
+    DeliverReadback(m_currentFrame);
+
+    if (IsOffscreen())
     {
-        RecreateSwapchain();
-        return;
+        m_currentImageIndex = m_currentFrame;
     }
-    else if (imageResult != VK_SUCCESS && imageResult != VK_SUBOPTIMAL_KHR)
+    else
     {
+        auto imageResult = vkAcquireNextImageKHR(
+            m_vkDevice,
+            m_vkSwapchain,
+            UINT64_MAX,
+            m_vkImageSemaphores[m_currentFrame],
+            VK_NULL_HANDLE,
+            &m_currentImageIndex
+        );
+        if (imageResult == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            RecreateSwapchain();
+            return;
+        }
+        else if (imageResult != VK_SUCCESS && imageResult != VK_SUBOPTIMAL_KHR)
+        {
 
-        throw std::runtime_error("Failed to acquire next swapchain image");
+            throw std::runtime_error("Failed to acquire next swapchain image");
+        }
     }
 
     VK_CHECK(
@@ -129,6 +189,14 @@ void Device::Begin()
         vkResetCommandBuffer(m_vkCommandBuffers[m_currentFrame], 0),
         "Failed to reset command buffer"
     );
+    VK_CHECK(
+        vkResetCommandBuffer(m_vkPrePassCommandBuffers[m_currentFrame], 0),
+        "Failed to reset pre-pass command buffer"
+    );
+    for (auto& pool : m_vkRecorderPools[m_currentFrame])
+    {
+        VK_CHECK(vkResetCommandPool(m_vkDevice, pool, 0), "Failed to reset recorder pool");
+    }
 
     VkCommandBufferBeginInfo beginInfo {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -137,6 +205,10 @@ void Device::Begin()
         vkBeginCommandBuffer(m_vkCommandBuffers[m_currentFrame], &beginInfo),
         "Failed to begin command buffer"
     );
+    VK_CHECK(
+        vkBeginCommandBuffer(m_vkPrePassCommandBuffers[m_currentFrame], &beginInfo),
+        "Failed to begin pre-pass command buffer"
+    );
 
     TransitionImageLayout(
         m_vkCommandBuffers[m_currentFrame],
@@ -145,6 +217,12 @@ void Device::Begin()
         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     );
 
+    BeginRendering(VK_ATTACHMENT_LOAD_OP_CLEAR, 0);
+    ResetViewport();
+}
+
+void Device::BeginRendering(VkAttachmentLoadOp loadOp, VkRenderingFlags flags)
+{
     VkClearValue clearColor {};
     clearColor.color = {
         {0.0f, 0.0f, 0.0f, 1.0f}
@@ -155,7 +233,7 @@ void Device::Begin()
     VkRenderingAttachmentInfoKHR colorAttachment {};
     colorAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
     colorAttachment.clearValue  = clearColor;
-    colorAttachment.loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.loadOp      = loadOp;
     colorAttachment.storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.imageView   = m_vkSwapchainImageViews[m_currentImageIndex];
     colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -164,7 +242,7 @@ void Device::Begin()
     VkRenderingAttachmentInfoKHR depthAttachment {};
     depthAttachment.sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
     depthAttachment.clearValue  = clearDepth;
-    depthAttachment.loadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.loadOp      = loadOp;
     depthAttachment.storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
     depthAttachment.imageView   = m_vkDepthImageView;
     depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
@@ -183,81 +261,215 @@ void Device::Begin()
     renderingInfo.pColorAttachments    = &colorAttachment;
     renderingInfo.pDepthAttachment     = &depthAttachment;
     renderingInfo.pStencilAttachment   = nullptr;
-    renderingInfo.flags                = 0;
+    renderingInfo.flags                = flags;
 
     _vkCmdBeginRenderingKHR(
         m_instance.GetVkInstance(),
         m_vkCommandBuffers[m_currentFrame],
         &renderingInfo
     );
+}
 
-    ResetViewport();
+void Device::EndRendering()
+{
+    _vkCmdEndRenderingKHR(m_instance.GetVkInstance(), m_vkCommandBuffers[m_currentFrame]);
 }
 
-void Device::ResetViewport()
+VkCommandBuffer Device::BeginSecondaryCommandBuffer(uint32_t recorder)
 {
-    VkViewport viewport {};
-    viewport.x        = 0.0f;
-    viewport.y        = 0.0f;
-    viewport.width    = static_cast<float>(m_vkSwapchainExtent.width);
-    viewport.height   = static_cast<float>(m_vkSwapchainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(m_vkCommandBuffers[m_currentFrame], 0, 1, &viewport);
+    auto commandBuffer = m_vkSecondaryCommandBuffers[m_currentFrame][recorder];
+
+    VkCommandBufferInheritanceRenderingInfo rendering {};
+    rendering.sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    rendering.colorAttachmentCount    = 1;
+    rendering.pColorAttachmentFormats = &m_vkSwapchainImageFormat;
+    rendering.depthAttachmentFormat   = GetDepthFormat();
+    rendering.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    rendering.rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.pNext = &rendering;
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+                                 | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    VK_CHECK(
+        vkBeginCommandBuffer(commandBuffer, &beginInfo),
+        "Failed to begin secondary command buffer"
+    );
 
-    VkRect2D scissor {};
-    scissor.offset = {0, 0};
-    scissor.extent = m_vkSwapchainExtent;
-    vkCmdSetScissor(m_vkCommandBuffers[m_currentFrame], 0, 1, &scissor);
+    // Dynamic state isn't inherited from the primary.
+    vkCmdSetViewport(commandBuffer, 0, 1, &m_viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &m_scissor);
+
+    return commandBuffer;
 }
 
-void Device::SetViewport(SRect rect)
+void Device::EndSecondaryCommandBuffer(uint32_t recorder)
+{
+    VK_CHECK(
+        vkEndCommandBuffer(m_vkSecondaryCommandBuffers[m_currentFrame][recorder]),
+        "Failed to end secondary command buffer"
+    );
+}
+
+void Device::ExecuteSecondaryCommandBuffers(uint32_t recorderCount)
+{
+    auto commandBuffer = m_vkCommandBuffers[m_currentFrame];
+
+    // A render pass instance either records inline or only executes secondaries,
+    // so the secondaries get one of their own that continues from the inline one.
+    // Attachment writes of one instance have to land before the next one loads them.
+    VkMemoryBarrier barrier {};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                            | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                            | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    const VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+                                        | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                                        | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+    auto continueRendering = [&](VkRenderingFlags flags)
+    {
+        EndRendering();
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            stages,
+            stages,
+            VK_DEPENDENCY_BY_REGION_BIT,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+        BeginRendering(VK_ATTACHMENT_LOAD_OP_LOAD, flags);
+    };
+
+    continueRendering(VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+    vkCmdExecuteCommands(
+        commandBuffer,
+        recorderCount,
+        m_vkSecondaryCommandBuffers[m_currentFrame].data()
+    );
+    continueRendering(0);
+
+    // Nothing bound before the secondaries is still bound, except the dynamic state set here.
+    vkCmdSetViewport(commandBuffer, 0, 1, &m_viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &m_scissor);
+}
+
+void Device::ResetViewport()
 {
-    VkViewport viewport {};
-    viewport.x        = static_cast<float>(rect.offset.x);
-    viewport.y        = static_cast<float>(rect.offset.y);
-    viewport.width    = static_cast<float>(rect.size.x);
-    viewport.height   = static_cast<float>(rect.size.y);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(m_vkCommandBuffers[m_currentFrame], 0, 1, &viewport);
+    m_viewport          = {};
+    m_viewport.x        = 0.0f;
+    m_viewport.y        = 0.0f;
+    m_viewport.width    = static_cast<float>(m_vkSwapchainExtent.width);
+    m_viewport.height   = static_cast<float>(m_vkSwapchainExtent.height);
+    m_viewport.minDepth = 0.0f;
+    m_viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(m_vkCommandBuffers[m_currentFrame], 0, 1, &m_viewport);
+
+    m_scissor        = {};
+    m_scissor.offset = {0, 0};
+    m_scissor.extent = m_vkSwapchainExtent;
+    vkCmdSetScissor(m_vkCommandBuffers[m_currentFrame], 0, 1, &m_scissor);
+}
 
-    VkRect2D scissor {};
-    scissor.offset = {rect.offset.x, rect.offset.y};
-    scissor.extent = {static_cast<uint32_t>(rect.size.x), static_cast<uint32_t>(rect.size.y)};
-    vkCmdSetScissor(m_vkCommandBuffers[m_currentFrame], 0, 1, &scissor);
+void Device::SetViewport(SRect rect)
+{
+    m_viewport          = {};
+    m_viewport.x        = static_cast<float>(rect.offset.x);
+    m_viewport.y        = static_cast<float>(rect.offset.y);
+    m_viewport.width    = static_cast<float>(rect.size.x);
+    m_viewport.height   = static_cast<float>(rect.size.y);
+    m_viewport.minDepth = 0.0f;
+    m_viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(m_vkCommandBuffers[m_currentFrame], 0, 1, &m_viewport);
+
+    m_scissor        = {};
+    m_scissor.offset = {rect.offset.x, rect.offset.y};
+    m_scissor.extent = {static_cast<uint32_t>(rect.size.x), static_cast<uint32_t>(rect.size.y)};
+    vkCmdSetScissor(m_vkCommandBuffers[m_currentFrame], 0, 1, &m_scissor);
 }
 
 void Device::Submit()
 {
-    _vkCmdEndRenderingKHR(m_instance.GetVkInstance(), m_vkCommandBuffers[m_currentFrame]);
+    EndRendering();
 
     TransitionImageLayout(
         m_vkCommandBuffers[m_currentFrame],
         m_vkSwapchainImages[m_currentImageIndex],
         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        IsOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
     );
 
+    if (m_readbacks[m_currentFrame].callback)
+    {
+        RecordReadback();
+    }
+
     VK_CHECK(
         vkEndCommandBuffer(m_vkCommandBuffers[m_currentFrame]),
         "Failed to end command buffer"
     );
 
+    // Indirect draws read what compute wrote in the pre-pass.
+    VkMemoryBarrier prePassBarrier {};
+    prePassBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    prePassBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    prePassBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        m_vkPrePassCommandBuffers[m_currentFrame],
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0,
+        1,
+        &prePassBarrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+
+    VK_CHECK(
+        vkEndCommandBuffer(m_vkPrePassCommandBuffers[m_currentFrame]),
+        "Failed to end pre-pass command buffer"
+    );
+
+    VkCommandBuffer commandBuffers[] = {
+        m_vkPrePassCommandBuffers[m_currentFrame],
+        m_vkCommandBuffers[m_currentFrame],
+    };
+
     VkSemaphore          waitSemaphores[]   = {m_vkImageSemaphores[m_currentFrame]};
     VkPipelineStageFlags waitStages[]       = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
     VkSemaphore          signalSemaphores[] = {m_vkRenderSemaphores[m_currentFrame]};
 
     VkSubmitInfo submitInfo {};
-    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount   = 1;
-    submitInfo.pCommandBuffers      = &m_vkCommandBuffers[m_currentFrame];
-    submitInfo.waitSemaphoreCount   = 1;
-    submitInfo.pWaitSemaphores      = waitSemaphores;
-    submitInfo.pWaitDstStageMask    = waitStages;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores    = signalSemaphores;
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 2;
+    submitInfo.pCommandBuffers    = commandBuffers;
+
+    // Nothing was acquired or gets presented offscreen, the fence is all there is.
+    if (!IsOffscreen())
+    {
+        submitInfo.waitSemaphoreCount   = 1;
+        submitInfo.pWaitSemaphores      = waitSemaphores;
+        submitInfo.pWaitDstStageMask    = waitStages;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores    = signalSemaphores;
+    }
 
+    auto queueLock = LockSharedQueue(m_vkGraphicsQueue);
     VK_CHECK(
         vkQueueSubmit(m_vkGraphicsQueue, 1, &submitInfo, m_vkInFlightFences[m_currentFrame]),
         "Failed to submit queue"
@@ -266,6 +478,12 @@ void Device::Submit()
 
 void Device::Present()
 {
+    if (IsOffscreen())
+    {
+        m_currentFrame = (m_currentFrame + 1) % m_maxFramesInFlight;
+        return;
+    }
+
     VkSemaphore    signalSemaphores[] = {m_vkRenderSemaphores[m_currentFrame]};
     VkSwapchainKHR swapchains[]       = {m_vkSwapchain};
 
@@ -277,11 +495,14 @@ void Device::Present()
     presentInfo.pSwapchains        = swapchains;
     presentInfo.pImageIndices      = &m_currentImageIndex;
 
-    auto presentResult = vkQueuePresentKHR(m_vkPresentQueue, &presentInfo);
-    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR
-        || m_frameBufferResized)
+    VkResult presentResult;
+    {
+        auto queueLock = LockSharedQueue(m_vkPresentQueue);
+        presentResult  = vkQueuePresentKHR(m_vkPresentQueue, &presentInfo);
+    }
+    const bool resized = m_frameBufferResized.exchange(false);
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR || resized)
     {
-        m_frameBufferResized = false;
         RecreateSwapchain();
     }
     else if (presentResult != VK_SUCCESS)
@@ -294,9 +515,128 @@ void Device::Present()
 
 void Device::WaitForGraphicsIdle()
 {
+    auto queueLock = LockSharedQueue(m_vkGraphicsQueue);
     vkQueueWaitIdle(m_vkGraphicsQueue);
 }
 
+void Device::ReadbackFrame(ReadbackCallback callback)
+{
+    if (!IsOffscreen())
+    {
+        throw std::runtime_error("Tried reading back a swapchain frame");
+    }
+
+    m_readbacks[m_currentFrame].callback = std::move(callback);
+}
+
+void Device::FlushReadbacks()
+{
+    for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+    {
+        if (!m_readbacks[i].callback)
+        {
+            continue;
+        }
+
+        VK_CHECK(
+            vkWaitForFences(m_vkDevice, 1, &m_vkInFlightFences[i], VK_TRUE, UINT64_MAX),
+            "Failed waiting for in flight fence"
+        );
+        DeliverReadback(i);
+    }
+}
+
+void Device::RecordReadback()
+{
+    auto&      readback = m_readbacks[m_currentFrame];
+    const auto extent   = m_vkSwapchainExtent;
+
+    // Tightly packed 4 byte pixels.
+    const auto size = extent.width * extent.height;
+    if (readback.buffer == nullptr || readback.buffer->GetElementCount() != size)
+    {
+        readback.buffer = std::make_shared<Buffer>(ReadbackBuffer, HostBuffer, 4, size);
+        readback.buffer->Map(&readback.mapped);
+    }
+    readback.extent = extent;
+
+    VkBufferImageCopy region {};
+    region.bufferOffset                    = 0;
+    region.bufferRowLength                 = 0;
+    region.bufferImageHeight               = 0;
+    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = 1;
+    region.imageOffset                     = {0, 0, 0};
+    region.imageExtent                     = {extent.width, extent.height, 1};
+
+    vkCmdCopyImageToBuffer(
+        m_vkCommandBuffers[m_currentFrame],
+        m_vkSwapchainImages[m_currentImageIndex],
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        readback.buffer->GetVkBuffer(),
+        1,
+        &region
+    );
+
+    // The fence covers execution, the host still needs the writes made visible to it.
+    VkMemoryBarrier barrier {};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(
+        m_vkCommandBuffers[m_currentFrame],
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+}
+
+void Device::DeliverReadback(uint32_t frame)
+{
+    auto& readback = m_readbacks[frame];
+    if (!readback.callback)
+    {
+        return;
+    }
+
+    SReadbackImage image {};
+    image.width  = readback.extent.width;
+    image.height = readback.extent.height;
+    image.format = m_vkSwapchainImageFormat;
+    image.pixels = static_cast<const uint8_t*>(readback.mapped);
+
+    // Cleared first, the callback may well ask for another readback.
+    auto callback     = std::move(readback.callback);
+    readback.callback = nullptr;
+    callback(image);
+}
+
+void Device::SubmitTransfer(const VkSubmitInfo& submitInfo, VkFence fence)
+{
+    auto queueLock = LockSharedQueue(m_vkTransferQueue);
+    VK_CHECK(
+        vkQueueSubmit(m_vkTransferQueue, 1, &submitInfo, fence),
+        "Failed to submit transfer queue"
+    );
+}
+
+std::unique_lock<std::mutex> Device::LockSharedQueue(VkQueue queue)
+{
+    if (queue != m_vkTransferQueue)
+    {
+        return {};
+    }
+    return std::unique_lock {m_queueMutex};
+}
+
 VkCommandBuffer Device::GetTemporaryCommandBuffer()
 {
     VkCommandBufferAllocateInfo allocInfo {};
@@ -333,10 +673,13 @@ void Device::SubmitTemporaryCommandBuffer(VkCommandBuffer commandBuffer)
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers    = &commandBuffer;
 
-    VK_CHECK(
-        vkQueueSubmit(m_vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE),
-        "Failed to submit temporary command buffer"
-    );
+    {
+        auto queueLock = LockSharedQueue(m_vkGraphicsQueue);
+        VK_CHECK(
+            vkQueueSubmit(m_vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE),
+            "Failed to submit temporary command buffer"
+        );
+    }
     // TODO: wait all copies with fences?
     WaitForGraphicsIdle();
 
@@ -360,12 +703,32 @@ void Device::DestroySwapchain()
         vkDestroyImageView(m_vkDevice, view, nullptr);
     }
 
-    vkDestroySwapchainKHR(m_vkDevice, m_vkSwapchain, nullptr);
+    if (IsOffscreen())
+    {
+        for (size_t i = 0; i < m_vkSwapchainImages.size(); i++)
+        {
+            vmaDestroyImage(g_vma, m_vkSwapchainImages[i], m_vmaOffscreenAllocations[i]);
+        }
+    }
+    else
+    {
+        vkDestroySwapchainKHR(m_vkDevice, m_vkSwapchain, nullptr);
+    }
 
     vkDestroyImageView(m_vkDevice, m_vkDepthImageView, nullptr);
     vmaDestroyImage(g_vma, m_vkDepthImage, m_vmaDepthAllocation);
 }
 
+std::vector<const char*> Device::GetRequiredExtensions() const
+{
+    std::vector<const char*> extensions = {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME};
+    if (!IsOffscreen())
+    {
+        extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+    return extensions;
+}
+
 void Device::PickPhysicalDevice()
 {
     LOG_DEBUG("Picking physical device");
@@ -382,13 +745,26 @@ void Device::PickPhysicalDevice()
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(m_instance.GetVkInstance(), &deviceCount, devices.data());
 
+    // Prefer a discrete GPU, anything else that works (integrated, lavapipe) is a fallback.
     for (const auto& device : devices)
     {
-        if (IsDeviceSuitable(device))
+        if (!IsDeviceSuitable(device))
+        {
+            continue;
+        }
+
+        VkPhysicalDeviceProperties deviceProperties {};
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
+        if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
         {
             m_vkPhysicalDevice = device;
             break;
         }
+
+        if (m_vkPhysicalDevice == VK_NULL_HANDLE)
+        {
+            m_vkPhysicalDevice = device;
+        }
     }
 
     if (m_vkPhysicalDevice == VK_NULL_HANDLE)
@@ -399,12 +775,13 @@ void Device::PickPhysicalDevice()
 
 bool Device::IsDeviceSuitable(const VkPhysicalDevice device)
 {
-    VkPhysicalDeviceProperties deviceProperties {};
-    vkGetPhysicalDeviceProperties(device, &deviceProperties);
+    VkPhysicalDeviceVulkan12Features vulkan12Features {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.pNext = nullptr;
 
     VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeature {};
     dynamicRenderingFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
-    dynamicRenderingFeature.pNext = nullptr;
+    dynamicRenderingFeature.pNext = &vulkan12Features;
 
     VkPhysicalDeviceFeatures2 deviceFeatures {};
     deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -414,21 +791,26 @@ bool Device::IsDeviceSuitable(const VkPhysicalDevice device)
 
     auto dynamicRenderingSupported = dynamicRenderingFeature.dynamicRendering == VK_TRUE;
 
-    auto featuresSupported = dynamicRenderingSupported;
+    auto drawIndirectCountSupported = vulkan12Features.drawIndirectCount == VK_TRUE;
+
+    auto firstInstanceSupported = deviceFeatures.features.drawIndirectFirstInstance == VK_TRUE;
+
+    auto featuresSupported =
+        dynamicRenderingSupported && drawIndirectCountSupported && firstInstanceSupported;
 
     auto familyIndices       = FindQueueFamilies(device);
     auto extensionsSupported = CheckDeviceExtensionSupport(device);
 
-    auto swapchainAdequate = false;
-    if (extensionsSupported)
+    // Offscreen targets are plain images, any device that renders will do.
+    auto swapchainAdequate = IsOffscreen();
+    if (extensionsSupported && !IsOffscreen())
     {
         auto swapchainSupport = QuerySwapchainSupport(device);
         swapchainAdequate =
             !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
     }
 
-    return deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU
-           && familyIndices.IsComplete() && featuresSupported && extensionsSupported
+    return familyIndices.IsComplete() && featuresSupported && extensionsSupported
            && swapchainAdequate;
 }
 
@@ -445,20 +827,44 @@ QueueFamilyIndices Device::FindQueueFamilies(const VkPhysicalDevice device)
     uint32_t i = 0;
     for (const auto& family : queueFamilies)
     {
-        if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        if (!familyIndices.IsComplete())
         {
-            familyIndices.graphicsFamily = i;
+            if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            {
+                familyIndices.graphicsFamily = i;
+            }
+
+            // Nothing is presented offscreen, graphics stands in for the present family.
+            VkBool32 presentSupport = false;
+            if (IsOffscreen())
+            {
+                presentSupport = (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+            }
+            else
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(
+                    device,
+                    i,
+                    m_instance.GetSurface(),
+                    &presentSupport
+                );
+            }
+
+            if (presentSupport)
+            {
+                familyIndices.presentFamily = i;
+            }
         }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_instance.GetSurface(), &presentSupport);
-
-        if (presentSupport)
+        const auto transferOnly = (family.queueFlags & VK_QUEUE_TRANSFER_BIT)
+                                  && !(family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                                  && !(family.queueFlags & VK_QUEUE_COMPUTE_BIT);
+        if (transferOnly && !familyIndices.transferFamily.has_value())
         {
-            familyIndices.presentFamily = i;
+            familyIndices.transferFamily = i;
         }
 
-        if (familyIndices.IsComplete())
+        if (familyIndices.IsComplete() && familyIndices.transferFamily.has_value())
         {
             break;
         }
@@ -466,6 +872,11 @@ QueueFamilyIndices Device::FindQueueFamilies(const VkPhysicalDevice device)
         i++;
     }
 
+    if (!familyIndices.transferFamily.has_value())
+    {
+        familyIndices.transferFamily = familyIndices.graphicsFamily;
+    }
+
     return familyIndices;
 }
 
@@ -481,7 +892,8 @@ bool Device::CheckDeviceExtensionSupport(const VkPhysicalDevice device)
         availableExtensions.data()
     );
 
-    std::set<std::string> uniqueRequired(m_requiredExtensions.begin(), m_requiredExtensions.end());
+    const auto            required = GetRequiredExtensions();
+    std::set<std::string> uniqueRequired(required.begin(), required.end());
     for (const auto& extension : availableExtensions)
     {
         uniqueRequired.erase(extension.extensionName);
@@ -596,6 +1008,12 @@ constexpr VkExtent2D Device::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& ca
 
 void Device::CreateSwapchain()
 {
+    if (IsOffscreen())
+    {
+        CreateOffscreenTargets();
+        return;
+    }
+
     auto support       = QuerySwapchainSupport(m_vkPhysicalDevice);
     auto surfaceFormat = ChooseSwapSurfaceFormat(support.formats);
     auto presentMode   = ChooseSwapPresentMode(support.presentModes);
@@ -647,14 +1065,50 @@ void Device::CreateSwapchain()
     m_vkSwapchainImageFormat = surfaceFormat.format;
     m_vkSwapchainExtent      = extent;
 
+    CreateDepthImage();
+}
+
+void Device::CreateOffscreenTargets()
+{
+    // Same 8 bit sRGB as the preferred surface format, byte order aside.
+    m_vkSwapchain            = VK_NULL_HANDLE;
+    m_vkSwapchainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    // One per frame in flight, a frame's image is free again once its fence signals.
+    m_vkSwapchainImages.resize(m_maxFramesInFlight);
+    m_vmaOffscreenAllocations.resize(m_maxFramesInFlight);
+    for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+    {
+        CreateImage(
+            &m_vkSwapchainImages[i],
+            &m_vmaOffscreenAllocations[i],
+            VK_IMAGE_TYPE_2D,
+            m_vkSwapchainImageFormat,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            m_vkSwapchainExtent.width,
+            m_vkSwapchainExtent.height
+        );
+    }
+
+    LOG_INFO(
+        "Rendering offscreen at {}x{}",
+        m_vkSwapchainExtent.width,
+        m_vkSwapchainExtent.height
+    );
+
+    CreateDepthImage();
+}
+
+void Device::CreateDepthImage()
+{
     CreateImage(
         &m_vkDepthImage,
         &m_vmaDepthAllocation,
         VK_IMAGE_TYPE_2D,
         GetDepthFormat(),
         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        extent.width,
-        extent.height
+        m_vkSwapchainExtent.width,
+        m_vkSwapchainExtent.height
     );
 }
 
@@ -751,7 +1205,8 @@ void Device::CreateLogicalDevice()
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t>                   uniqueQueueFamilies = {
         familyIndices.graphicsFamily.value(),
-        familyIndices.presentFamily.value()
+        familyIndices.presentFamily.value(),
+        familyIndices.transferFamily.value(),
     };
 
     auto queuePriority = 1.0f;
@@ -765,23 +1220,34 @@ void Device::CreateLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // Culled draws are issued with vkCmdDrawIndexedIndirectCount.
+    VkPhysicalDeviceVulkan12Features vulkan12Features {};
+    vulkan12Features.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.drawIndirectCount = VK_TRUE;
+    vulkan12Features.pNext             = nullptr;
+
     VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeature {};
     dynamicRenderingFeature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
     dynamicRenderingFeature.dynamicRendering = VK_TRUE;
-    dynamicRenderingFeature.pNext            = nullptr;
+    dynamicRenderingFeature.pNext            = &vulkan12Features;
 
     VkPhysicalDeviceFeatures2 deviceFeatures {};
     deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
     deviceFeatures.pNext = &dynamicRenderingFeature;
 
+    // Culled draws pass their model index as firstInstance.
+    deviceFeatures.features.drawIndirectFirstInstance = VK_TRUE;
+
+    const auto extensions = GetRequiredExtensions();
+
     VkDeviceCreateInfo deviceCreateInfo {};
     deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
     deviceCreateInfo.queueCreateInfoCount    = static_cast<uint32_t>(queueCreateInfos.size());
     deviceCreateInfo.pEnabledFeatures        = nullptr; // handled in pNext
     deviceCreateInfo.pNext                   = &deviceFeatures;
-    deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(m_requiredExtensions.size());
-    deviceCreateInfo.ppEnabledExtensionNames = m_requiredExtensions.data();
+    deviceCreateInfo.enabledExtensionCount   = static_cast<uint32_t>(extensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
 
     VK_CHECK(
         vkCreateDevice(m_vkPhysicalDevice, &deviceCreateInfo, nullptr, &m_vkDevice),
@@ -790,8 +1256,16 @@ void Device::CreateLogicalDevice()
 
     m_vkGraphicsQueueIndex = familyIndices.graphicsFamily.value();
     m_vkPresentQueueIndex  = familyIndices.presentFamily.value();
+    m_vkTransferQueueIndex = familyIndices.transferFamily.value();
     vkGetDeviceQueue(m_vkDevice, m_vkGraphicsQueueIndex, 0, &m_vkGraphicsQueue);
     vkGetDeviceQueue(m_vkDevice, m_vkPresentQueueIndex, 0, &m_vkPresentQueue);
+    vkGetDeviceQueue(m_vkDevice, m_vkTransferQueueIndex, 0, &m_vkTransferQueue);
+
+    LOG_DEBUG(
+        "Transfer queue family {}{}",
+        m_vkTransferQueueIndex,
+        m_vkTransferQueue == m_vkGraphicsQueue ? " (shared with graphics)" : ""
+    );
 }
 
 void Device::CreateCommandPool()
@@ -812,6 +1286,7 @@ void Device::CreateCommandPool()
 void Device::CreateCommandBuffers()
 {
     m_vkCommandBuffers.resize(m_maxFramesInFlight);
+    m_vkPrePassCommandBuffers.resize(m_maxFramesInFlight);
 
     VkCommandBufferAllocateInfo allocInfo {};
     allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -823,6 +1298,53 @@ void Device::CreateCommandBuffers()
         vkAllocateCommandBuffers(m_vkDevice, &allocInfo, m_vkCommandBuffers.data()),
         "Failed to allocate command buffers"
     );
+
+    VK_CHECK(
+        vkAllocateCommandBuffers(m_vkDevice, &allocInfo, m_vkPrePassCommandBuffers.data()),
+        "Failed to allocate pre-pass command buffers"
+    );
+}
+
+void Device::CreateRecorders()
+{
+    auto familyIndices = FindQueueFamilies(m_vkPhysicalDevice);
+
+    VkCommandPoolCreateInfo poolInfo {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = familyIndices.graphicsFamily.value();
+
+    m_vkRecorderPools.resize(m_maxFramesInFlight);
+    m_vkSecondaryCommandBuffers.resize(m_maxFramesInFlight);
+    for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+    {
+        m_vkRecorderPools[i].resize(m_recorderCount);
+        m_vkSecondaryCommandBuffers[i].resize(m_recorderCount);
+
+        for (uint32_t recorder = 0; recorder < m_recorderCount; recorder++)
+        {
+            auto& pool = m_vkRecorderPools[i][recorder];
+            VK_CHECK(
+                vkCreateCommandPool(m_vkDevice, &poolInfo, nullptr, &pool),
+                "Failed to create recorder command pool"
+            );
+
+            VkCommandBufferAllocateInfo allocInfo {};
+            allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool        = pool;
+            allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            VK_CHECK(
+                vkAllocateCommandBuffers(
+                    m_vkDevice,
+                    &allocInfo,
+                    &m_vkSecondaryCommandBuffers[i][recorder]
+                ),
+                "Failed to allocate secondary command buffer"
+            );
+        }
+    }
 }
 
 void Device::CreateSyncObjects()
@@ -857,15 +1379,23 @@ void Device::CreateSyncObjects()
 
 void Device::CreateDescriptorPools()
 {
-    VkDescriptorPoolSize uboPoolSize {};
-    uboPoolSize.type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboPoolSize.descriptorCount = m_maxFramesInFlight;
+    // Frame, view and object sets for every frame in flight.
+    std::array<VkDescriptorPoolSize, 3> uboPoolSizes {};
+    // Frame and view uniforms.
+    uboPoolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboPoolSizes[0].descriptorCount = 2 * m_maxFramesInFlight;
+    uboPoolSizes[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    // Model matrices, culling input, indirect draws and their counts.
+    uboPoolSizes[1].descriptorCount = 4 * m_maxFramesInFlight;
+    // Per-draw data.
+    uboPoolSizes[2].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    uboPoolSizes[2].descriptorCount = m_maxFramesInFlight;
 
     VkDescriptorPoolCreateInfo uboPoolInfo {};
     uboPoolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    uboPoolInfo.poolSizeCount = 1;
-    uboPoolInfo.pPoolSizes    = &uboPoolSize;
-    uboPoolInfo.maxSets       = m_maxFramesInFlight;
+    uboPoolInfo.poolSizeCount = static_cast<uint32_t>(uboPoolSizes.size());
+    uboPoolInfo.pPoolSizes    = uboPoolSizes.data();
+    uboPoolInfo.maxSets       = 3 * m_maxFramesInFlight;
 
     VK_CHECK(
         vkCreateDescriptorPool(m_vkDevice, &uboPoolInfo, nullptr, &m_vkUboDescriptorPool),
@@ -888,4 +1418,87 @@ void Device::CreateDescriptorPools()
         "Failed to create ImGui descriptor pool"
     );
 }
+
+void Device::CreatePipelineCache()
+{
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+
+    // Whatever is on disk only seeds the cache if it came from this exact device and driver,
+    // the driver checks the data itself too but not every one does it reliably.
+    std::vector<char> data;
+    std::ifstream     file(PIPELINE_CACHE_PATH, std::ios::binary);
+    if (file)
+    {
+        std::vector<char> contents {std::istreambuf_iterator<char>(file), {}};
+
+        SPipelineCacheHeader header {};
+        if (contents.size() >= sizeof(header))
+        {
+            std::memcpy(&header, contents.data(), sizeof(header));
+        }
+
+        if (header.magic == PipelineCacheMagic
+            && header.dataSize == contents.size() - sizeof(header)
+            && header.vendorID == properties.vendorID && header.deviceID == properties.deviceID
+            && header.driverVersion == properties.driverVersion
+            && std::memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+        {
+            const auto offset = static_cast<std::ptrdiff_t>(sizeof(header));
+            data.assign(contents.begin() + offset, contents.end());
+            LOG_INFO("Loaded {} bytes of pipeline cache", data.size());
+        }
+        else
+        {
+            LOG_WARN("Discarding pipeline cache from a different device or driver");
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo {};
+    cacheInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData    = data.empty() ? nullptr : data.data();
+
+    VK_CHECK(
+        vkCreatePipelineCache(m_vkDevice, &cacheInfo, nullptr, &m_vkPipelineCache),
+        "Failed to create pipeline cache"
+    );
+}
+
+void Device::SavePipelineCache()
+{
+    size_t size = 0;
+    VK_CHECK(
+        vkGetPipelineCacheData(m_vkDevice, m_vkPipelineCache, &size, nullptr),
+        "Failed to get pipeline cache size"
+    );
+
+    std::vector<char> data(size);
+    VK_CHECK(
+        vkGetPipelineCacheData(m_vkDevice, m_vkPipelineCache, &size, data.data()),
+        "Failed to get pipeline cache data"
+    );
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+
+    SPipelineCacheHeader header {};
+    header.magic         = PipelineCacheMagic;
+    header.dataSize      = static_cast<uint32_t>(size);
+    header.vendorID      = properties.vendorID;
+    header.deviceID      = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::ofstream file(PIPELINE_CACHE_PATH, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), static_cast<std::streamsize>(size));
+
+    if (!file)
+    {
+        LOG_WARN("Failed to write pipeline cache to {}", PIPELINE_CACHE_PATH);
+        return;
+    }
+    LOG_INFO("Saved {} bytes of pipeline cache", size);
+}
 } // namespace legs
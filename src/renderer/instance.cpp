@@ -125,7 +125,10 @@ Instance::~Instance()
 {
     LOG_DEBUG("Destroying Instance");
 
-    vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
+    if (m_vkSurface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(m_vkInstance, m_vkSurface, nullptr);
+    }
 
     if (m_enableValidationLayers)
     {
@@ -144,15 +147,20 @@ void Instance::SetWindow(std::shared_ptr<Window> window)
 
 std::vector<const char*> Instance::GetRequiredExtensions()
 {
-    unsigned int extensionCount = 0;
-    if (!m_window->GetExtensions(&extensionCount, nullptr))
+    // Offscreen needs no surface extensions.
+    std::vector<const char*> extensions;
+    if (!IsOffscreen())
     {
-        throw std::runtime_error("Failed to get vulkan extensions from window");
-    }
-    std::vector<const char*> extensions(extensionCount);
-    if (!m_window->GetExtensions(&extensionCount, extensions.data()))
-    {
-        throw std::runtime_error("Failed to get vulkan extensions from window");
+        unsigned int extensionCount = 0;
+        if (!m_window->GetExtensions(&extensionCount, nullptr))
+        {
+            throw std::runtime_error("Failed to get vulkan extensions from window");
+        }
+        extensions.resize(extensionCount);
+        if (!m_window->GetExtensions(&extensionCount, extensions.data()))
+        {
+            throw std::runtime_error("Failed to get vulkan extensions from window");
+        }
     }
 
     if (m_enableValidationLayers)
@@ -224,6 +232,12 @@ void Instance::SetupDebugMessenger()
 
 void Instance::CreateSurface()
 {
+    m_vkSurface = VK_NULL_HANDLE;
+    if (IsOffscreen())
+    {
+        return;
+    }
+
     auto result = m_window->CreateSurface(m_vkInstance, &m_vkSurface);
     if (!result)
     {
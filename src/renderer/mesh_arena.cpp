@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <legs/log.hpp>
+#include <legs/renderer/mesh_arena.hpp>
+
+namespace legs
+{
+// Enough for a handful of detailed meshes before the first grow.
+static constexpr uint32_t InitialVertexCapacity = 64 * 1024;
+static constexpr uint32_t InitialIndexCapacity  = 256 * 1024;
+
+static bool IsReady(const std::shared_future<void>& future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+MeshArena::MeshArena(Uploader& uploader, std::vector<uint32_t> queueFamilies) :
+    m_uploader(uploader),
+    m_queueFamilies(std::move(queueFamilies))
+{
+    LOG_INFO("Creating MeshArena");
+
+    m_indexPool.type        = IndexBuffer;
+    m_indexPool.elementSize = sizeof(Index);
+}
+
+std::shared_ptr<SMeshAllocation> MeshArena::Create(
+    VertexFormat              format,
+    uint32_t                  vertexSize,
+    const void*               vertices,
+    uint32_t                  vertexCount,
+    const std::vector<Index>& indices,
+    const SBoundingSphere&    bounds
+)
+{
+    if (vertexCount == 0 || indices.empty())
+    {
+        throw std::runtime_error("Tried creating an empty mesh");
+    }
+
+    std::scoped_lock arenaLock {m_mutex};
+
+    auto& vertexPool = m_vertexPools[static_cast<size_t>(format)];
+    if (vertexPool.elementSize == 0)
+    {
+        vertexPool.type        = VertexBuffer;
+        vertexPool.elementSize = vertexSize;
+    }
+
+    auto mesh          = new SMeshAllocation {};
+    mesh->format       = format;
+    mesh->vertexCount  = vertexCount;
+    mesh->indexCount   = static_cast<uint32_t>(indices.size());
+    mesh->vertexOffset = Allocate(vertexPool, mesh->vertexCount);
+    mesh->firstIndex   = Allocate(m_indexPool, mesh->indexCount);
+    mesh->bounds       = bounds;
+    mesh->generation   = m_generation;
+
+    auto verticesUploaded = Write(vertexPool, mesh->vertexOffset, vertices, mesh->vertexCount);
+    auto indicesUploaded  = Write(m_indexPool, mesh->firstIndex, indices.data(), mesh->indexCount);
+
+    // Staged uploads finish in order, so the later one covers both.
+    mesh->uploaded = IsReady(indicesUploaded) ? verticesUploaded : indicesUploaded;
+
+    m_meshes.insert(mesh);
+
+    return std::shared_ptr<SMeshAllocation>(
+        mesh,
+        [arena = weak_from_this()](SMeshAllocation* allocation)
+        {
+            if (auto owner = arena.lock())
+            {
+                owner->Free(allocation);
+            }
+            delete allocation;
+        }
+    );
+}
+
+void MeshArena::Free(SMeshAllocation* mesh)
+{
+    std::scoped_lock arenaLock {m_mutex};
+
+    auto& vertexPool = m_vertexPools[static_cast<size_t>(mesh->format)];
+    vertexPool.freeList.Free(mesh->vertexOffset, mesh->vertexCount);
+    m_indexPool.freeList.Free(mesh->firstIndex, mesh->indexCount);
+    m_meshes.erase(mesh);
+}
+
+uint32_t MeshArena::Allocate(SPool& pool, uint32_t count)
+{
+    if (auto offset = pool.freeList.Allocate(count))
+    {
+        return *offset;
+    }
+
+    const auto capacity = pool.freeList.GetCapacity();
+    if (capacity == 0)
+    {
+        const auto initial =
+            pool.type == IndexBuffer ? InitialIndexCapacity : InitialVertexCapacity;
+        Grow(pool, std::max(initial, count));
+    }
+    else
+    {
+        Grow(pool, std::max(capacity * 2, capacity + count));
+    }
+
+    return pool.freeList.Allocate(count).value();
+}
+
+void MeshArena::Grow(SPool& pool, uint32_t capacity)
+{
+    auto buffer = std::make_shared<Buffer>(
+        pool.type,
+        DeviceBuffer,
+        pool.elementSize,
+        capacity,
+        m_queueFamilies,
+        HostWriteAccess
+    );
+
+    // Existing meshes keep their offsets, so the whole old buffer moves over as is.
+    // Until the copy is done frames keep drawing from the old one.
+    if (pool.buffer != nullptr)
+    {
+        const VkBufferCopy region {
+            0,
+            0,
+            static_cast<VkDeviceSize>(pool.freeList.GetCapacity()) * pool.elementSize,
+        };
+        pool.copied = m_uploader.Copy(pool.buffer, buffer, {region});
+    }
+
+    LOG_DEBUG(
+        "Growing mesh arena {} buffer from {} to {} elements",
+        pool.type == IndexBuffer ? "index" : "vertex",
+        pool.freeList.GetCapacity(),
+        capacity
+    );
+
+    pool.buffer = buffer;
+    pool.freeList.Grow(capacity);
+    m_generation++;
+}
+
+void MeshArena::Pack(SPool& pool, std::optional<VertexFormat> format)
+{
+    // Offset and size of the range each mesh uses in this pool.
+    auto range = [&](SMeshAllocation* mesh) -> std::pair<uint32_t&, uint32_t>
+    {
+        if (format.has_value())
+        {
+            return {mesh->vertexOffset, mesh->vertexCount};
+        }
+        return {mesh->firstIndex, mesh->indexCount};
+    };
+
+    std::vector<SMeshAllocation*> meshes;
+    for (auto mesh : m_meshes)
+    {
+        if (!format.has_value() || mesh->format == *format)
+        {
+            meshes.push_back(mesh);
+        }
+    }
+
+    std::sort(
+        meshes.begin(),
+        meshes.end(),
+        [&](SMeshAllocation* a, SMeshAllocation* b) { return range(a).first < range(b).first; }
+    );
+
+    auto buffer = std::make_shared<Buffer>(
+        pool.type,
+        DeviceBuffer,
+        pool.elementSize,
+        pool.freeList.GetCapacity(),
+        m_queueFamilies,
+        HostWriteAccess
+    );
+
+    m_generation++;
+    pool.freeList.Reset();
+
+    std::vector<VkBufferCopy> regions;
+    regions.reserve(meshes.size());
+    for (auto mesh : meshes)
+    {
+        auto [offset, count] = range(mesh);
+        const auto packed    = pool.freeList.Allocate(count).value();
+
+        regions.push_back({
+            static_cast<VkDeviceSize>(offset) * pool.elementSize,
+            static_cast<VkDeviceSize>(packed) * pool.elementSize,
+            static_cast<VkDeviceSize>(count) * pool.elementSize,
+        });
+
+        offset           = packed;
+        mesh->generation = m_generation;
+    }
+
+    pool.copied = m_uploader.Copy(pool.buffer, buffer, regions);
+    pool.buffer = buffer;
+}
+
+void MeshArena::Defragment()
+{
+    std::scoped_lock arenaLock {m_mutex};
+
+    size_t packed = 0;
+    for (size_t i = 0; i < m_vertexPools.size(); i++)
+    {
+        auto& pool = m_vertexPools[i];
+        if (pool.buffer != nullptr && pool.freeList.IsFragmented())
+        {
+            Pack(pool, static_cast<VertexFormat>(i));
+            packed++;
+        }
+    }
+
+    if (m_indexPool.buffer != nullptr && m_indexPool.freeList.IsFragmented())
+    {
+        Pack(m_indexPool, std::nullopt);
+        packed++;
+    }
+
+    LOG_INFO("Defragmented {} mesh arena buffers with {} meshes", packed, m_meshes.size());
+}
+
+void MeshArena::BeginFrame()
+{
+    std::scoped_lock arenaLock {m_mutex};
+
+    // A buffer still being copied into isn't picked up yet,
+    // neither are the meshes created or moved since the last frame.
+    bool current = true;
+
+    auto pickUp = [&](const SPool& pool, std::shared_ptr<Buffer>& frameBuffer)
+    {
+        if (pool.copied.valid() && !IsReady(pool.copied))
+        {
+            current = false;
+            return;
+        }
+        frameBuffer = pool.buffer;
+    };
+
+    for (size_t i = 0; i < m_vertexPools.size(); i++)
+    {
+        pickUp(m_vertexPools[i], m_frameVertexBuffers[i]);
+    }
+    pickUp(m_indexPool, m_frameIndexBuffer);
+
+    if (current)
+    {
+        m_frameGeneration = m_generation;
+    }
+}
+
+bool MeshArena::GetFrameBuffers(
+    VertexFormat             format,
+    std::shared_ptr<Buffer>& vertexBuffer,
+    std::shared_ptr<Buffer>& indexBuffer
+) const
+{
+    vertexBuffer = m_frameVertexBuffers[static_cast<size_t>(format)];
+    indexBuffer  = m_frameIndexBuffer;
+    return vertexBuffer != nullptr && indexBuffer != nullptr;
+}
+
+std::shared_future<void> MeshArena::Write(
+    SPool&      pool,
+    uint32_t    offset,
+    const void* data,
+    uint32_t    count
+)
+{
+    const auto size        = static_cast<size_t>(count) * pool.elementSize;
+    const auto destination = static_cast<size_t>(offset) * pool.elementSize;
+
+    // Writing directly while a copy into the buffer is in flight could get overwritten by it,
+    // staging orders the write after the copy.
+    if (pool.buffer->IsHostVisible() && (!pool.copied.valid() || IsReady(pool.copied)))
+    {
+        pool.buffer->Write(const_cast<void*>(data), size, destination);
+
+        std::promise<void> written;
+        written.set_value();
+        return written.get_future().share();
+    }
+
+    return m_uploader.Upload(pool.buffer, data, size, destination);
+}
+} // namespace legs
@@ -0,0 +1,57 @@
+#include <fstream>
+#include <vector>
+
+#include <legs/log.hpp>
+#include <legs/renderer/readback.hpp>
+
+namespace legs
+{
+bool WritePPM(const std::string& path, const SReadbackImage& image)
+{
+    bool swapRedBlue = false;
+    switch (image.format)
+    {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        {
+            break;
+        }
+
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        {
+            swapRedBlue = true;
+            break;
+        }
+
+        default:
+        {
+            LOG_WARN("Can't write format {} as PPM", static_cast<int>(image.format));
+            return false;
+        }
+    }
+
+    const auto pixelCount = static_cast<size_t>(image.width) * image.height;
+
+    std::vector<uint8_t> rgb(pixelCount * 3);
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        const auto* pixel = image.pixels + i * 4;
+        rgb[i * 3 + 0]    = pixel[swapRedBlue ? 2 : 0];
+        rgb[i * 3 + 1]    = pixel[1];
+        rgb[i * 3 + 2]    = pixel[swapRedBlue ? 0 : 2];
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(rgb.size()));
+
+    if (!file)
+    {
+        LOG_WARN("Failed to write {}", path);
+        return false;
+    }
+
+    return true;
+}
+} // namespace legs
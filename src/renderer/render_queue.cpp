@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+
+#include <legs/renderer/render_queue.hpp>
+
+namespace legs
+{
+uint64_t RenderQueue::MakeKey(
+    uint32_t pipeline,
+    uint32_t vertexBufferId,
+    uint32_t indexBufferId,
+    float    depth
+)
+{
+    static constexpr uint64_t IdMask = (1 << 20) - 1;
+
+    // Non-negative floats sort the same as their bits,
+    // the top half keeps the exponent and enough of the mantissa.
+    const auto depthBits = std::bit_cast<uint32_t>(std::max(depth, 0.0f)) >> 16;
+
+    return (static_cast<uint64_t>(pipeline & 0xff) << 56) | ((vertexBufferId & IdMask) << 36)
+           | ((indexBufferId & IdMask) << 16) | depthBits;
+}
+
+void RenderQueue::Sort()
+{
+    if (m_packets.size() < 2)
+    {
+        return;
+    }
+
+    m_scratch.resize(m_packets.size());
+
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::array<size_t, 256> offsets {};
+        for (const auto& packet : m_packets)
+        {
+            offsets[(packet.key >> shift) & 0xff]++;
+        }
+
+        // Every key has the same byte here, nothing would move.
+        const auto first = (m_packets.front().key >> shift) & 0xff;
+        if (offsets[first] == m_packets.size())
+        {
+            continue;
+        }
+
+        std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), size_t {0});
+
+        for (const auto& packet : m_packets)
+        {
+            m_scratch[offsets[(packet.key >> shift) & 0xff]++] = packet;
+        }
+        m_packets.swap(m_scratch);
+    }
+}
+} // namespace legs
@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <imgui_impl_vulkan.h>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include <legs/log.hpp>
 #include <legs/renderer/mesh_data.hpp>
@@ -10,68 +14,77 @@ namespace legs
 {
 
 #define MAX_FRAMES_IN_FLIGHT 2
+#define STAGING_RING_SIZE (32 * 1024 * 1024)
+#define MAX_RECORDERS 8u
 
-Renderer::Renderer(std::shared_ptr<Window> window) :
+static uint32_t GetRecorderCount()
+{
+    return std::clamp(std::thread::hardware_concurrency(), 1u, MAX_RECORDERS);
+}
+
+Renderer::Renderer(std::shared_ptr<Window> window, VkExtent2D offscreenExtent) :
     m_instance(window),
-    m_device(m_instance, MAX_FRAMES_IN_FLIGHT)
+    m_device(m_instance, MAX_FRAMES_IN_FLIGHT, GetRecorderCount(), offscreenExtent)
 {
     LOG_INFO("Creating Renderer");
 
-    auto uboBuffers = std::vector<std::shared_ptr<Buffer>>();
-    for (unsigned int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    m_uploader = std::make_unique<Uploader>(m_device, STAGING_RING_SIZE);
+    m_uploadQueueFamilies.push_back(m_device.GetGraphicsQueueIndex());
+    if (m_device.GetTransferQueueIndex() != m_device.GetGraphicsQueueIndex())
     {
-        uboBuffers.push_back(
-            std::make_shared<Buffer>(UniformBuffer, HostBuffer, sizeof(UniformBufferObject), 1)
-        );
+        m_uploadQueueFamilies.push_back(m_device.GetTransferQueueIndex());
     }
-    m_descriptorSet = std::make_shared<DescriptorSet>(m_device, uboBuffers);
-
-    // TODO: abstract away all the shader + pipeline setup
-    auto moduleSimpleFrag = CreateShaderModule(LOAD_VULKAN_SPV(unlit_pc_frag));
-    auto moduleSimpleVert = CreateShaderModule(LOAD_VULKAN_SPV(unlit_pc_vert));
-    auto stageSimpleFrag =
-        FillShaderStageCreateInfo(moduleSimpleFrag, VK_SHADER_STAGE_FRAGMENT_BIT);
-    auto stageSimpleVert = FillShaderStageCreateInfo(moduleSimpleVert, VK_SHADER_STAGE_VERTEX_BIT);
-    std::vector simpleStages {stageSimpleFrag, stageSimpleVert};
-
-    m_testPipeline =
-        std::make_shared<Pipeline<Vertex_P_C>>(m_device, m_descriptorSet, simpleStages);
-
-    auto moduleGeoPNCFrag = CreateShaderModule(LOAD_VULKAN_SPV(lit_pnc_frag));
-    auto moduleGeoPNCVert = CreateShaderModule(LOAD_VULKAN_SPV(lit_pnc_vert));
-    auto stageGeoPNCFrag =
-        FillShaderStageCreateInfo(moduleGeoPNCFrag, VK_SHADER_STAGE_FRAGMENT_BIT);
-    auto stageGeoPNCVert = FillShaderStageCreateInfo(moduleGeoPNCVert, VK_SHADER_STAGE_VERTEX_BIT);
-    std::vector geoPNCStages {stageGeoPNCFrag, stageGeoPNCVert};
-
-    m_geoPNCPipeline =
-        std::make_shared<Pipeline<Vertex_P_N_C>>(m_device, m_descriptorSet, geoPNCStages);
-
-    auto moduleFullscreenFrag = CreateShaderModule(LOAD_VULKAN_SPV(fullscreen_frag));
-    auto moduleFullscreenVert = CreateShaderModule(LOAD_VULKAN_SPV(fullscreen_vert));
-    auto stageFullscreenFrag =
-        FillShaderStageCreateInfo(moduleFullscreenFrag, VK_SHADER_STAGE_FRAGMENT_BIT);
-    auto stageFullscreenVert =
-        FillShaderStageCreateInfo(moduleFullscreenVert, VK_SHADER_STAGE_VERTEX_BIT);
-    std::vector fullscreenStages {stageFullscreenFrag, stageFullscreenVert};
-
-    m_fullscreenPipeline = std::make_shared<Pipeline<VertexEmpty>>(
+    m_meshArena = std::make_shared<MeshArena>(*m_uploader, m_uploadQueueFamilies);
+
+    m_descriptorSet = std::make_shared<DescriptorSet>(m_device, MAX_FRAMES_IN_FLIGHT);
+
+    m_pipelineDescs = {
+        {GEO_P_C, LOAD_VULKAN_SPV(unlit_pc_vert), LOAD_VULKAN_SPV(unlit_pc_frag)},
+        {GEO_P_N_C, LOAD_VULKAN_SPV(lit_pnc_vert), LOAD_VULKAN_SPV(lit_pnc_frag)},
+        {SKY, LOAD_VULKAN_SPV(sky_vert), LOAD_VULKAN_SPV(sky_frag)},
+        // Only used for clearing viewports.
+        {FULLSCREEN,
+         LOAD_VULKAN_SPV(fullscreen_vert),
+         LOAD_VULKAN_SPV(fullscreen_frag),
+         false,
+         false,
+         true},
+    };
+
+    // Pipelines compile independently, each eager one gets its own thread
+    // and they all share the device's pipeline cache.
+    std::vector<std::future<void>> pipelinesCreated;
+    for (const auto& desc : m_pipelineDescs)
+    {
+        if (!desc.lazy)
+        {
+            pipelinesCreated.push_back(std::async(
+                std::launch::async,
+                [this, pipeline = desc.pipeline]()
+                {
+                    CreatePipeline(pipeline);
+                }
+            ));
+        }
+    }
+
+    auto moduleCullComp = CreateShaderModule(LOAD_VULKAN_SPV(cull_comp));
+    auto stageCullComp  = FillShaderStageCreateInfo(moduleCullComp, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    m_cullPipeline = std::make_unique<ComputePipeline>(
         m_device,
         m_descriptorSet,
-        fullscreenStages,
-        false,
-        false
+        stageCullComp,
+        static_cast<uint32_t>(sizeof(uint32_t))
     );
 
-    auto moduleSkyFrag = CreateShaderModule(LOAD_VULKAN_SPV(sky_frag));
-    auto moduleSkyVert = CreateShaderModule(LOAD_VULKAN_SPV(sky_vert));
-    auto stageSkyFrag  = FillShaderStageCreateInfo(moduleSkyFrag, VK_SHADER_STAGE_FRAGMENT_BIT);
-    auto stageSkyVert  = FillShaderStageCreateInfo(moduleSkyVert, VK_SHADER_STAGE_VERTEX_BIT);
-    std::vector skyStages {stageSkyFrag, stageSkyVert};
-
-    m_skyPipeline = std::make_shared<Pipeline<Vertex_P>>(m_device, m_descriptorSet, skyStages);
+    // Rethrows whatever failed on the other threads.
+    for (auto& created : pipelinesCreated)
+    {
+        created.get();
+    }
 
-    m_ubo = std::make_shared<UniformBufferObject>();
+    m_frameUbo = std::make_shared<FrameBufferObject>();
 }
 
 Renderer::~Renderer()
@@ -80,10 +93,14 @@ Renderer::~Renderer()
 
     vkDeviceWaitIdle(m_device.GetVkDevice());
 
+    m_meshArena.reset();
+    m_uploader.reset();
+
     m_testPipeline.reset();
     m_geoPNCPipeline.reset();
     m_fullscreenPipeline.reset();
     m_skyPipeline.reset();
+    m_cullPipeline.reset();
 
     m_descriptorSet.reset();
 
@@ -91,8 +108,6 @@ Renderer::~Renderer()
     {
         vkDestroyShaderModule(m_device.GetVkDevice(), module, nullptr);
     }
-
-    m_frameBuffers.clear();
 }
 
 void Renderer::SetWindow(std::shared_ptr<Window> window)
@@ -107,6 +122,7 @@ void Renderer::ClearViewport()
     auto commandBuffer = m_device.GetCommandBuffer();
     BindPipeline(RenderPipeline::FULLSCREEN);
     vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+    m_drawCalls++;
 }
 
 void Renderer::Resize()
@@ -123,15 +139,34 @@ float Renderer::GetAspect()
 void Renderer::Begin()
 {
     m_device.Begin();
+    m_descriptorSet->ResetDrawData(m_device.GetCurrentFrame());
+    m_drawCalls        = 0;
+    m_visibleObjects   = 0;
+    m_culledObjects    = 0;
+    m_gpuCulledObjects = 0;
+    m_pipelineBinds    = 0;
+    m_bufferBinds      = 0;
+
+    if (m_defragmentRequested.exchange(false))
+    {
+        m_meshArena->Defragment();
+    }
+
+    // Everything staged since the last frame goes out in one submit,
+    // buffers whose uploads finished become drawable.
+    m_uploader->Flush();
+    m_uploader->Poll();
+    m_meshArena->BeginFrame();
+    m_boundMeshFormat.reset();
+    m_boundPipeline = RenderPipeline::INVALID;
+
+    m_cullObjects.clear();
+    m_cullBatches.clear();
 }
 
 void Renderer::Submit()
 {
     m_device.Submit();
-
-    // Not ideal but guarantees chunk buffers aren't freed too early.
-    m_device.WaitForGraphicsIdle();
-    m_frameBuffers.clear();
 }
 
 void Renderer::Present()
@@ -142,12 +177,324 @@ void Renderer::Present()
 void Renderer::UpdateUBO()
 {
     auto currentFrame = m_device.GetCurrentFrame();
-    m_descriptorSet->UpdateUBO(currentFrame, m_ubo);
+    m_descriptorSet->UpdateFrameUBO(currentFrame, *m_frameUbo);
+    m_descriptorSet->UpdateViewUBO(currentFrame, m_view, m_viewRevision);
+}
+
+void Renderer::UpdateObjects(const std::vector<glm::mat4>& models)
+{
+    auto currentFrame = m_device.GetCurrentFrame();
+    m_descriptorSet->UpdateObjects(currentFrame, models);
+
+    m_gpuCulledObjects = static_cast<uint32_t>(m_cullObjects.size());
+    if (m_cullObjects.empty())
+    {
+        return;
+    }
+
+    // Every batch has room for all of its objects, visible ones get packed to the front
+    // and the count tells the indirect draw how many there are.
+    uint32_t firstCommand = 0;
+    for (auto& batch : m_cullBatches)
+    {
+        batch.firstCommand  = firstCommand;
+        firstCommand       += batch.objectCount;
+    }
+    for (auto& object : m_cullObjects)
+    {
+        object.firstCommand = m_cullBatches[object.batch].firstCommand;
+    }
+
+    const auto batchCount  = static_cast<uint32_t>(m_cullBatches.size());
+    const auto objectCount = static_cast<uint32_t>(m_cullObjects.size());
+    m_descriptorSet->UpdateCullObjects(currentFrame, m_cullObjects, batchCount);
+
+    auto prePass     = m_device.GetPrePassCommandBuffer();
+    auto countBuffer = m_descriptorSet->GetDrawCountBuffer(currentFrame);
+    vkCmdFillBuffer(prePass, countBuffer->GetVkBuffer(), 0, batchCount * sizeof(uint32_t), 0);
+
+    VkMemoryBarrier barrier {};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        prePass,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr
+    );
+
+    m_cullPipeline->Bind(prePass, currentFrame);
+    m_cullPipeline->PushConstants(prePass, &objectCount, sizeof(objectCount));
+    vkCmdDispatch(prePass, (objectCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+}
+
+void Renderer::CullSpheres(const std::vector<glm::vec4>& spheres, std::vector<uint8_t>& visible)
+{
+    const auto frustum = SFrustum::FromViewProjection(m_view.viewProj);
+    const auto count   = legs::CullSpheres(frustum, spheres, visible);
+
+    m_visibleObjects += count;
+    m_culledObjects  += static_cast<uint32_t>(spheres.size()) - count;
+}
+
+void Renderer::AddCulledObject(
+    RenderPipeline                          pipeline,
+    const std::shared_ptr<SMeshAllocation>& mesh,
+    uint32_t                                model
+)
+{
+    if (!m_meshArena->IsDrawable(*mesh))
+    {
+        return;
+    }
+
+    // Only a handful of batches, one per pipeline and vertex format.
+    auto batch = std::find_if(
+        m_cullBatches.begin(),
+        m_cullBatches.end(),
+        [&](const SCullBatch& other)
+        {
+            return other.pipeline == pipeline && other.format == mesh->format;
+        }
+    );
+    if (batch == m_cullBatches.end())
+    {
+        m_cullBatches.push_back({pipeline, mesh->format, 0, 0});
+        batch = std::prev(m_cullBatches.end());
+    }
+    batch->objectCount++;
+
+    SCullObject object {};
+    object.bounds       = glm::vec4(mesh->bounds.center, mesh->bounds.radius);
+    object.firstIndex   = mesh->firstIndex;
+    object.indexCount   = mesh->indexCount;
+    object.vertexOffset = static_cast<int32_t>(mesh->vertexOffset);
+    object.batch        = static_cast<uint32_t>(batch - m_cullBatches.begin());
+    object.model        = model;
+    m_cullObjects.push_back(object);
+
+    // The ranges can't be handed out again while the GPU may still read them.
+    m_device.DeferRelease(mesh);
+}
+
+void Renderer::DrawCulled()
+{
+    auto commandBuffer = m_device.GetCommandBuffer();
+    if (commandBuffer == nullptr || m_cullObjects.empty())
+    {
+        return;
+    }
+
+    auto currentFrame   = m_device.GetCurrentFrame();
+    auto commandsBuffer = m_descriptorSet->GetDrawCommandBuffer(currentFrame);
+    auto countBuffer    = m_descriptorSet->GetDrawCountBuffer(currentFrame);
+
+    for (size_t i = 0; i < m_cullBatches.size(); i++)
+    {
+        const auto& batch = m_cullBatches[i];
+        if (!BindMeshBuffers(commandBuffer, batch.format))
+        {
+            continue;
+        }
+
+        BindPipeline(batch.pipeline);
+        vkCmdDrawIndexedIndirectCount(
+            commandBuffer,
+            commandsBuffer->GetVkBuffer(),
+            batch.firstCommand * sizeof(VkDrawIndexedIndirectCommand),
+            countBuffer->GetVkBuffer(),
+            i * sizeof(uint32_t),
+            batch.objectCount,
+            sizeof(VkDrawIndexedIndirectCommand)
+        );
+        m_drawCalls++;
+    }
+
+    m_cullObjects.clear();
+    m_cullBatches.clear();
+}
+
+void Renderer::PushConstants(const void* data, uint32_t size)
+{
+    if (size > MaxPushConstantSize)
+    {
+        throw std::runtime_error("Tried to push more constants than a pipeline has room for");
+    }
+
+    auto commandBuffer = m_device.GetCommandBuffer();
+    VisitBoundPipeline([&](auto& pipeline) { pipeline.PushConstants(commandBuffer, data, size); });
+}
+
+bool Renderer::SetDrawData(const void* data, uint32_t size)
+{
+    auto currentFrame = m_device.GetCurrentFrame();
+    auto offset       = m_descriptorSet->WriteDrawData(currentFrame, data, size);
+    if (!offset.has_value())
+    {
+        return false;
+    }
+
+    auto commandBuffer = m_device.GetCommandBuffer();
+    VisitBoundPipeline(
+        [&](auto& pipeline)
+        {
+            pipeline.BindDrawData(commandBuffer, currentFrame, *offset);
+        }
+    );
+    return true;
+}
+
+void Renderer::DrawList(const std::vector<SDraw>& draws, JPH::JobSystem* jobSystem)
+{
+    // Fewer draws than this per slice aren't worth a job and a secondary command buffer.
+    static constexpr size_t MinDrawsPerRecorder = 64;
+
+    auto commandBuffer = m_device.GetCommandBuffer();
+    if (commandBuffer == nullptr || draws.empty())
+    {
+        return;
+    }
+
+    // Whatever the slices share is set up here, on the render thread.
+    for (const auto& draw : draws)
+    {
+        if (!IsPipelineCreated(draw.pipeline))
+        {
+            CreatePipeline(draw.pipeline);
+        }
+        m_device.DeferRelease(draw.vertexBuffer);
+        m_device.DeferRelease(draw.indexBuffer);
+    }
+
+    const auto recorders = std::min<size_t>(
+        m_device.GetRecorderCount(),
+        draws.size() / MinDrawsPerRecorder
+    );
+    if (jobSystem == nullptr || recorders < 2)
+    {
+        m_drawCalls += RecordDraws(commandBuffer, draws, 0, draws.size());
+        m_boundMeshFormat.reset();
+        m_boundPipeline = RenderPipeline::INVALID;
+        return;
+    }
+
+    const auto sliceSize = (draws.size() + recorders - 1) / recorders;
+
+    std::vector<uint32_t>       recorded(recorders);
+    std::vector<JPH::JobHandle> jobs;
+    jobs.reserve(recorders);
+
+    auto barrier = jobSystem->CreateBarrier();
+    for (size_t recorder = 0; recorder < recorders; recorder++)
+    {
+        const auto begin = recorder * sliceSize;
+        const auto end   = std::min(begin + sliceSize, draws.size());
+        jobs.push_back(jobSystem->CreateJob(
+            "Record draws",
+            JPH::Color::sOrange,
+            [&, recorder, begin, end]()
+            {
+                const auto index     = static_cast<uint32_t>(recorder);
+                auto       secondary = m_device.BeginSecondaryCommandBuffer(index);
+                recorded[recorder]   = RecordDraws(secondary, draws, begin, end);
+                m_device.EndSecondaryCommandBuffer(index);
+            }
+        ));
+    }
+    barrier->AddJobs(jobs.data(), static_cast<JPH::uint>(jobs.size()));
+
+    // Also records slices on this thread while waiting.
+    jobSystem->WaitForJobs(barrier);
+    jobSystem->DestroyBarrier(barrier);
+
+    m_device.ExecuteSecondaryCommandBuffers(static_cast<uint32_t>(recorders));
+    m_boundMeshFormat.reset();
+    m_boundPipeline = RenderPipeline::INVALID;
+
+    for (auto count : recorded)
+    {
+        m_drawCalls += count;
+    }
+}
+
+uint32_t Renderer::RecordDraws(
+    VkCommandBuffer           commandBuffer,
+    const std::vector<SDraw>& draws,
+    size_t                    begin,
+    size_t                    end
+)
+{
+    auto    pipeline     = RenderPipeline::INVALID;
+    Buffer* vertexBuffer = nullptr;
+    Buffer* indexBuffer  = nullptr;
+
+    uint32_t recorded = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        const auto& draw = draws[i];
+        if (!draw.vertexBuffer->IsReady() || !draw.indexBuffer->IsReady())
+        {
+            continue;
+        }
+
+        if (draw.pipeline != pipeline)
+        {
+            pipeline = draw.pipeline;
+            BindPipeline(commandBuffer, pipeline);
+        }
+        if (draw.vertexBuffer.get() != vertexBuffer)
+        {
+            vertexBuffer = draw.vertexBuffer.get();
+            vertexBuffer->Bind(commandBuffer);
+            m_bufferBinds++;
+        }
+        if (draw.indexBuffer.get() != indexBuffer)
+        {
+            indexBuffer = draw.indexBuffer.get();
+            indexBuffer->Bind(commandBuffer);
+            m_bufferBinds++;
+        }
+
+        indexBuffer->Draw(commandBuffer, draw.instanceCount, draw.firstInstance);
+        recorded++;
+    }
+    return recorded;
+}
+
+bool Renderer::BindMeshBuffers(VkCommandBuffer commandBuffer, VertexFormat format)
+{
+    if (m_boundMeshFormat == format)
+    {
+        return true;
+    }
+
+    std::shared_ptr<Buffer> vertexBuffer;
+    std::shared_ptr<Buffer> indexBuffer;
+    if (!m_meshArena->GetFrameBuffers(format, vertexBuffer, indexBuffer))
+    {
+        return false;
+    }
+
+    vertexBuffer->Bind(commandBuffer);
+    indexBuffer->Bind(commandBuffer);
+    m_bufferBinds += 2;
+    m_device.DeferRelease(vertexBuffer);
+    m_device.DeferRelease(indexBuffer);
+    m_boundMeshFormat = format;
+    return true;
 }
 
 void Renderer::WaitForIdle()
 {
     vkDeviceWaitIdle(m_device.GetVkDevice());
+    m_device.FlushReadbacks();
 }
 
 void Renderer::GetImGuiInfo(ImGuiCreationInfo& info)
@@ -169,7 +516,7 @@ void Renderer::GetImGuiInfo(ImGuiCreationInfo& info)
     info.imGuiInfo.Device                      = m_device.GetVkDevice();
     info.imGuiInfo.QueueFamily                 = m_device.GetGraphicsQueueIndex();
     info.imGuiInfo.Queue                       = m_device.GetGraphicsQueue();
-    info.imGuiInfo.PipelineCache               = VK_NULL_HANDLE; // TODO
+    info.imGuiInfo.PipelineCache               = m_device.GetPipelineCache();
     info.imGuiInfo.DescriptorPool              = m_device.GetImGuiDescriptorPool();
     info.imGuiInfo.UseDynamicRendering         = true;
     info.imGuiInfo.PipelineRenderingCreateInfo = info.pipelineCreateInfo;
@@ -180,14 +527,93 @@ void Renderer::GetImGuiInfo(ImGuiCreationInfo& info)
     info.imGuiInfo.CheckVkResultFn             = ImGuiVkCheck;
 }
 
-VkShaderModule& Renderer::CreateShaderModule(VkShaderModuleCreateInfo createInfo)
+void Renderer::CreatePipeline(RenderPipeline pipeline)
+{
+    auto desc = std::find_if(
+        m_pipelineDescs.begin(),
+        m_pipelineDescs.end(),
+        [&](const SPipelineDesc& candidate) { return candidate.pipeline == pipeline; }
+    );
+    if (desc == m_pipelineDescs.end())
+    {
+        throw std::runtime_error("unknown pipeline");
+    }
+
+    auto moduleVert = CreateShaderModule(desc->vertexShader);
+    auto moduleFrag = CreateShaderModule(desc->fragmentShader);
+    std::vector stages {
+        FillShaderStageCreateInfo(moduleFrag, VK_SHADER_STAGE_FRAGMENT_BIT),
+        FillShaderStageCreateInfo(moduleVert, VK_SHADER_STAGE_VERTEX_BIT),
+    };
+
+    switch (pipeline)
+    {
+        case GEO_P_C:
+        {
+            m_testPipeline = std::make_shared<Pipeline<Vertex_P_C>>(
+                m_device,
+                m_descriptorSet,
+                stages,
+                desc->enableCulling,
+                desc->enableDepth
+            );
+            break;
+        }
+
+        case GEO_P_N_C:
+        {
+            m_geoPNCPipeline = std::make_shared<Pipeline<Vertex_P_N_C>>(
+                m_device,
+                m_descriptorSet,
+                stages,
+                desc->enableCulling,
+                desc->enableDepth
+            );
+            break;
+        }
+
+        case FULLSCREEN:
+        {
+            m_fullscreenPipeline = std::make_shared<Pipeline<VertexEmpty>>(
+                m_device,
+                m_descriptorSet,
+                stages,
+                desc->enableCulling,
+                desc->enableDepth
+            );
+            break;
+        }
+
+        case SKY:
+        {
+            m_skyPipeline = std::make_shared<Pipeline<Vertex_P>>(
+                m_device,
+                m_descriptorSet,
+                stages,
+                desc->enableCulling,
+                desc->enableDepth
+            );
+            break;
+        }
+
+        default:
+        {
+            throw std::runtime_error("unknown pipeline");
+        }
+    }
+}
+
+VkShaderModule Renderer::CreateShaderModule(VkShaderModuleCreateInfo createInfo)
 {
     VkShaderModule module;
     VK_CHECK(
         vkCreateShaderModule(m_device.GetVkDevice(), &createInfo, nullptr, &module),
         "Failed to create shader module"
     );
-    return m_vkShaderModules.emplace_back(module);
+
+    std::scoped_lock moduleLock {m_shaderModuleMutex};
+    m_vkShaderModules.push_back(module);
+    return module;
 }
 
 constexpr VkPipelineShaderStageCreateInfo Renderer::FillShaderStageCreateInfo(
@@ -0,0 +1,367 @@
+#include <cstring>
+#include <stdexcept>
+
+#include <legs/log.hpp>
+#include <legs/renderer/common.hpp>
+#include <legs/renderer/uploader.hpp>
+
+namespace legs
+{
+// Keeps every staged copy's source offset aligned.
+static constexpr size_t StagingAlignment = 16;
+
+static constexpr size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+Uploader::Uploader(Device& device, size_t ringSize) : m_device(device), m_ringSize(ringSize)
+{
+    LOG_INFO("Creating Uploader");
+
+    VkCommandPoolCreateInfo poolInfo {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = m_device.GetTransferQueueIndex();
+
+    VK_CHECK(
+        vkCreateCommandPool(m_device.GetVkDevice(), &poolInfo, nullptr, &m_vkCommandPool),
+        "Failed to create upload command pool"
+    );
+
+    m_ring = std::make_unique<Buffer>(
+        StagingBuffer,
+        HostBuffer,
+        1,
+        static_cast<uint32_t>(m_ringSize)
+    );
+
+    void* ringMemory;
+    m_ring->Map(&ringMemory);
+    m_ringMemory = static_cast<uint8_t*>(ringMemory);
+}
+
+Uploader::~Uploader()
+{
+    LOG_INFO("Destroying Uploader");
+
+    WaitIdle();
+
+    for (auto& batch : m_freeBatches)
+    {
+        vkDestroyFence(m_device.GetVkDevice(), batch->fence, nullptr);
+    }
+    m_freeBatches.clear();
+
+    // Frees the batches' command buffers as well.
+    vkDestroyCommandPool(m_device.GetVkDevice(), m_vkCommandPool, nullptr);
+
+    m_ring.reset();
+}
+
+std::shared_future<void> Uploader::Upload(
+    std::shared_ptr<Buffer> destination,
+    const void*             data,
+    size_t                  size,
+    size_t                  destinationOffset
+)
+{
+    if (destination->GetLocation() != DeviceBuffer)
+    {
+        throw std::runtime_error("Tried uploading to a non-device buffer");
+    }
+
+    if (destinationOffset + size > destination->GetSize())
+    {
+        throw std::runtime_error("Tried uploading more data than allocated");
+    }
+
+    std::scoped_lock uploadLock {m_mutex};
+
+    VkBuffer source       = VK_NULL_HANDLE;
+    size_t   sourceOffset = 0;
+    size_t   consumed     = 0;
+
+    if (size > m_ringSize)
+    {
+        auto staging =
+            std::make_unique<Buffer>(StagingBuffer, HostBuffer, 1, static_cast<uint32_t>(size));
+        staging->Write(const_cast<void*>(data), size);
+        source = staging->GetVkBuffer();
+
+        if (m_recording == nullptr)
+        {
+            BeginBatch();
+        }
+        m_recording->oversized.push_back(std::move(staging));
+    }
+    else
+    {
+        // Ring is full, make room by waiting for the oldest submit.
+        while (!TryAllocate(size, sourceOffset, consumed))
+        {
+            if (m_inFlight.empty())
+            {
+                SubmitLocked();
+            }
+            RetireLocked(true);
+        }
+
+        std::memcpy(m_ringMemory + sourceOffset, data, size);
+        m_ring->Flush(sourceOffset, size);
+        source = m_ring->GetVkBuffer();
+
+        if (m_recording == nullptr)
+        {
+            BeginBatch();
+        }
+    }
+
+    VkBufferCopy copyRegion {};
+    copyRegion.srcOffset = sourceOffset;
+    copyRegion.dstOffset = destinationOffset;
+    copyRegion.size      = size;
+    vkCmdCopyBuffer(m_recording->commandBuffer, source, destination->GetVkBuffer(), 1, &copyRegion);
+
+    destination->BeginUpload();
+    m_recording->ringBytes += consumed;
+    m_recording->destinations.push_back(std::move(destination));
+    return m_recording->future;
+}
+
+std::shared_future<void> Uploader::Copy(
+    std::shared_ptr<Buffer>          source,
+    std::shared_ptr<Buffer>          destination,
+    const std::vector<VkBufferCopy>& regions
+)
+{
+    std::scoped_lock uploadLock {m_mutex};
+
+    if (m_recording == nullptr)
+    {
+        BeginBatch();
+    }
+
+    // Copies on a queue aren't ordered by themselves, the source may still be getting
+    // written by earlier uploads and later ones may write over parts of the destination.
+    VkMemoryBarrier barrier {};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    auto recordBarrier = [&]()
+    {
+        vkCmdPipelineBarrier(
+            m_recording->commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+    };
+
+    recordBarrier();
+    if (!regions.empty())
+    {
+        vkCmdCopyBuffer(
+            m_recording->commandBuffer,
+            source->GetVkBuffer(),
+            destination->GetVkBuffer(),
+            static_cast<uint32_t>(regions.size()),
+            regions.data()
+        );
+    }
+    recordBarrier();
+
+    destination->BeginUpload();
+    m_recording->destinations.push_back(std::move(destination));
+    m_recording->sources.push_back(std::move(source));
+    return m_recording->future;
+}
+
+void Uploader::Flush()
+{
+    std::scoped_lock uploadLock {m_mutex};
+    SubmitLocked();
+}
+
+void Uploader::Poll()
+{
+    std::scoped_lock uploadLock {m_mutex};
+    RetireLocked(false);
+}
+
+void Uploader::WaitIdle()
+{
+    std::scoped_lock uploadLock {m_mutex};
+    SubmitLocked();
+    while (!m_inFlight.empty())
+    {
+        RetireLocked(true);
+    }
+}
+
+void Uploader::BeginBatch()
+{
+    if (!m_freeBatches.empty())
+    {
+        m_recording = std::move(m_freeBatches.back());
+        m_freeBatches.pop_back();
+
+        VK_CHECK(
+            vkResetFences(m_device.GetVkDevice(), 1, &m_recording->fence),
+            "Failed to reset upload fence"
+        );
+        VK_CHECK(
+            vkResetCommandBuffer(m_recording->commandBuffer, 0),
+            "Failed to reset upload command buffer"
+        );
+    }
+    else
+    {
+        m_recording = std::make_unique<SBatch>();
+
+        VkCommandBufferAllocateInfo allocInfo {};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool        = m_vkCommandPool;
+        allocInfo.commandBufferCount = 1;
+
+        VK_CHECK(
+            vkAllocateCommandBuffers(
+                m_device.GetVkDevice(),
+                &allocInfo,
+                &m_recording->commandBuffer
+            ),
+            "Failed to allocate upload command buffer"
+        );
+
+        VkFenceCreateInfo fenceInfo {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VK_CHECK(
+            vkCreateFence(m_device.GetVkDevice(), &fenceInfo, nullptr, &m_recording->fence),
+            "Failed to create upload fence"
+        );
+    }
+
+    m_recording->done   = std::promise<void>();
+    m_recording->future = m_recording->done.get_future().share();
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VK_CHECK(
+        vkBeginCommandBuffer(m_recording->commandBuffer, &beginInfo),
+        "Failed to begin upload command buffer"
+    );
+}
+
+bool Uploader::TryAllocate(size_t size, size_t& offset, size_t& consumed)
+{
+    const auto aligned = AlignUp(size, StagingAlignment);
+    if (m_ringUsed + aligned > m_ringSize)
+    {
+        return false;
+    }
+
+    if (m_ringUsed == 0)
+    {
+        m_ringHead = 0;
+    }
+
+    // Free space is [head, tail) if the used part doesn't wrap,
+    // otherwise [head, end) followed by [0, tail).
+    const auto tail = (m_ringHead + m_ringSize - m_ringUsed) % m_ringSize;
+    if (m_ringUsed != 0 && m_ringHead < tail)
+    {
+        if (m_ringHead + aligned > tail)
+        {
+            return false;
+        }
+        offset   = m_ringHead;
+        consumed = aligned;
+    }
+    else if (m_ringHead + aligned <= m_ringSize)
+    {
+        offset   = m_ringHead;
+        consumed = aligned;
+    }
+    else if (aligned <= tail)
+    {
+        // Skip the end of the ring, a copy source has to be contiguous.
+        offset   = 0;
+        consumed = m_ringSize - m_ringHead + aligned;
+    }
+    else
+    {
+        return false;
+    }
+
+    m_ringUsed += consumed;
+    m_ringHead  = (offset + aligned) % m_ringSize;
+    return true;
+}
+
+void Uploader::SubmitLocked()
+{
+    if (m_recording == nullptr)
+    {
+        return;
+    }
+
+    VK_CHECK(
+        vkEndCommandBuffer(m_recording->commandBuffer),
+        "Failed to end upload command buffer"
+    );
+
+    VkSubmitInfo submitInfo {};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &m_recording->commandBuffer;
+
+    m_device.SubmitTransfer(submitInfo, m_recording->fence);
+    m_inFlight.push_back(std::move(m_recording));
+}
+
+void Uploader::RetireLocked(bool waitOldest)
+{
+    while (!m_inFlight.empty())
+    {
+        auto& batch = m_inFlight.front();
+        if (waitOldest)
+        {
+            VK_CHECK(
+                vkWaitForFences(m_device.GetVkDevice(), 1, &batch->fence, VK_TRUE, UINT64_MAX),
+                "Failed waiting for upload fence"
+            );
+            waitOldest = false;
+        }
+        else if (vkGetFenceStatus(m_device.GetVkDevice(), batch->fence) != VK_SUCCESS)
+        {
+            break;
+        }
+
+        for (auto& destination : batch->destinations)
+        {
+            destination->EndUpload();
+        }
+        batch->destinations.clear();
+        batch->sources.clear();
+        batch->oversized.clear();
+
+        m_ringUsed       -= batch->ringBytes;
+        batch->ringBytes  = 0;
+        batch->done.set_value();
+
+        m_freeBatches.push_back(std::move(batch));
+        m_inFlight.pop_front();
+    }
+}
+} // namespace legs
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <format>
+
+#include <legs/log.hpp>
+#include <legs/system_scheduler.hpp>
+#include <legs/time.hpp>
+
+namespace legs
+{
+SystemScheduler::SystemScheduler(SystemPhase phase) : m_phase(phase)
+{
+}
+
+void SystemScheduler::Add(std::shared_ptr<ISystem> system)
+{
+    std::scoped_lock schedulerLock {m_mutex};
+    m_pending.push_back(system);
+    m_dirty = true;
+}
+
+void SystemScheduler::Rebuild()
+{
+    std::scoped_lock schedulerLock {m_mutex};
+
+    m_nodes.clear();
+    for (size_t i = 0; i < m_pending.size(); i++)
+    {
+        auto& node  = m_nodes.emplace_back();
+        node.system = m_pending[i];
+        node.system->DeclareAccess(node.access);
+        node.name = std::format("{} #{}", node.system->GetName(), i);
+    }
+
+    // Edges only point forward, from a system to later ones it conflicts with,
+    // which keeps the graph acyclic and conflicting systems in insertion order.
+    for (size_t j = 0; j < m_nodes.size(); j++)
+    {
+        for (size_t i = 0; i < j; i++)
+        {
+            if (!m_nodes[i].access.ConflictsWith(m_nodes[j].access))
+            {
+                continue;
+            }
+
+            m_nodes[i].dependents.push_back(j);
+            m_nodes[j].dependencies++;
+            m_nodes[j].level = std::max(m_nodes[j].level, m_nodes[i].level + 1);
+        }
+    }
+
+    m_times = std::make_unique<std::atomic<double>[]>(m_nodes.size());
+    m_dirty = false;
+
+    LOG_DEBUG(
+        "Built {} schedule with {} systems",
+        m_phase == SystemPhase::FRAME ? "frame" : "tick",
+        m_nodes.size()
+    );
+}
+
+void SystemScheduler::RunNode(size_t index)
+{
+    const auto start = Time::Now();
+
+    auto& system = m_nodes[index].system;
+    if (m_phase == SystemPhase::FRAME)
+    {
+        system->OnFrame();
+    }
+    else
+    {
+        system->OnTick();
+    }
+
+    m_times[index] = Time::Now() - start;
+}
+
+void SystemScheduler::Run(JPH::JobSystem* jobSystem)
+{
+    bool dirty;
+    {
+        std::scoped_lock schedulerLock {m_mutex};
+        dirty = m_dirty;
+    }
+
+    if (dirty)
+    {
+        Rebuild();
+    }
+
+    const auto start = Time::Now();
+
+    // Exclusive systems split the schedule into groups,
+    // each group runs as a graph on the job system with the exclusive system after it.
+    size_t groupBegin = 0;
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        if (!m_nodes[i].access.IsExclusive())
+        {
+            continue;
+        }
+
+        RunGroup(groupBegin, i, jobSystem);
+        RunNode(i);
+        groupBegin = i + 1;
+    }
+    RunGroup(groupBegin, m_nodes.size(), jobSystem);
+
+    m_lastTime = Time::Now() - start;
+}
+
+void SystemScheduler::RunGroup(size_t begin, size_t end, JPH::JobSystem* jobSystem)
+{
+    if (end - begin <= 1 || jobSystem == nullptr)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            RunNode(i);
+        }
+        return;
+    }
+
+    // Dependencies on exclusive systems outside the group are already satisfied.
+    auto dependenciesInGroup = [&](size_t index)
+    {
+        uint32_t count = 0;
+        for (size_t i = begin; i < index; i++)
+        {
+            const auto& dependents = m_nodes[i].dependents;
+            if (std::find(dependents.begin(), dependents.end(), index) != dependents.end())
+            {
+                count++;
+            }
+        }
+        return count;
+    };
+
+    // Create back to front, so every job's dependents exist before it can start
+    // and release them.
+    m_handles.resize(end - begin);
+    for (size_t i = end; i-- > begin;)
+    {
+        m_handles[i - begin] = jobSystem->CreateJob(
+            m_nodes[i].name.c_str(),
+            JPH::Color::sCyan,
+            [this, i, begin, end]()
+            {
+                RunNode(i);
+                for (auto dependent : m_nodes[i].dependents)
+                {
+                    if (dependent < end)
+                    {
+                        m_handles[dependent - begin].RemoveDependency();
+                    }
+                }
+            },
+            dependenciesInGroup(i)
+        );
+    }
+
+    auto barrier = jobSystem->CreateBarrier();
+    barrier->AddJobs(m_handles.data(), static_cast<JPH::uint>(m_handles.size()));
+    jobSystem->WaitForJobs(barrier);
+    jobSystem->DestroyBarrier(barrier);
+
+    m_handles.clear();
+}
+
+std::vector<SSystemTiming> SystemScheduler::GetTimings() const
+{
+    std::scoped_lock schedulerLock {m_mutex};
+
+    std::vector<SSystemTiming> timings;
+    timings.reserve(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); i++)
+    {
+        const auto& node = m_nodes[i];
+        timings.push_back({
+            node.name,
+            node.level,
+            node.access.IsExclusive(),
+            node.access.ReadCount(),
+            node.access.WriteCount(),
+            m_times[i].load(),
+        });
+    }
+    return timings;
+}
+
+double SystemScheduler::GetLastTime() const
+{
+    return m_lastTime;
+}
+} // namespace legs
@@ -42,6 +42,14 @@ UI::~UI()
     ImGui::DestroyContext();
 }
 
+void UI::ProcessEvents(const std::vector<SDL_Event>& events)
+{
+    for (const auto& event : events)
+    {
+        ImGui_ImplSDL2_ProcessEvent(&event);
+    }
+}
+
 void UI::Render()
 {
     // Start new frame
@@ -49,8 +57,13 @@ void UI::Render()
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
 
+    // Main thread decides what input goes to the engine from this
+    const ImGuiIO& io = ImGui::GetIO();
+    m_window->SetUICapture(io.WantCaptureKeyboard, io.WantCaptureMouse);
+
     DebugWindow();
     DemoWindow();
+    SystemsWindow();
 
     // Prep data for renderer implementation
     ImGui::Render();
@@ -85,6 +98,24 @@ void UI::DebugWindow()
         auto ren = std::format("  Render: {:.2f} ms", Time::DeltaRender * 1000.0);
         ImGui::Text("%s", ren.c_str());
 
+        auto draws = std::format("  Draws: {:d}", m_renderer->GetDrawCalls());
+        ImGui::Text("%s", draws.c_str());
+
+        auto culled = std::format(
+            "  Culled: {:d}, visible: {:d}, GPU: {:d}",
+            m_renderer->GetCulledObjects(),
+            m_renderer->GetVisibleObjects(),
+            m_renderer->GetGPUCulledObjects()
+        );
+        ImGui::Text("%s", culled.c_str());
+
+        auto binds = std::format(
+            "  Binds: {:d} pipelines, {:d} buffers",
+            m_renderer->GetPipelineBinds(),
+            m_renderer->GetBufferBinds()
+        );
+        ImGui::Text("%s", binds.c_str());
+
         auto tps =
             std::format("TPS: {:.0f} ({:.2f} ms)", 1.0 / Time::DeltaTick, Time::DeltaTick * 1000.0);
         ImGui::Text("%s", tps.c_str());
@@ -96,6 +127,71 @@ void UI::DebugWindow()
     }
 }
 
+void UI::SystemsWindow()
+{
+    if (!m_state.showWindow[static_cast<unsigned int>(UIWindow::SYSTEMS)])
+    {
+        return;
+    }
+
+    if (ImGui::Begin(
+            "Systems",
+            &m_state.showWindow[static_cast<unsigned int>(UIWindow::SYSTEMS)],
+            ImGuiWindowFlags_AlwaysAutoResize
+        ))
+    {
+        SystemsTable("Frame", m_frameSystems);
+        SystemsTable("Tick", m_tickSystems);
+    }
+    ImGui::End();
+}
+
+void UI::SystemsTable(const char* label, const SystemScheduler* scheduler)
+{
+    if (scheduler == nullptr)
+    {
+        return;
+    }
+
+    auto header = std::format("{}: {:.3f} ms", label, scheduler->GetLastTime() * 1000.0);
+    ImGui::SeparatorText(header.c_str());
+
+    if (ImGui::BeginTable(label, 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Level");
+        ImGui::TableSetupColumn("System");
+        ImGui::TableSetupColumn("Access");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableHeadersRow();
+
+        // Systems on the same level can run at the same time.
+        for (const auto& timing : scheduler->GetTimings())
+        {
+            ImGui::TableNextRow();
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", timing.level);
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", timing.name.c_str());
+
+            ImGui::TableNextColumn();
+            if (timing.exclusive)
+            {
+                ImGui::Text("exclusive");
+            }
+            else
+            {
+                ImGui::Text("R%zu W%zu", timing.reads, timing.writes);
+            }
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", timing.lastTime * 1000.0);
+        }
+        ImGui::EndTable();
+    }
+}
+
 void UI::DemoWindow()
 {
     if (!m_state.showWindow[static_cast<unsigned int>(UIWindow::DEMO)])
@@ -1,5 +1,3 @@
-#include <imgui.h>
-#include <imgui_impl_sdl2.h>
 #include <SDL.h>
 #include <SDL_events.h>
 #include <SDL_mouse.h>
@@ -79,11 +77,10 @@ bool Window::IsMouseGrabbed()
     return SDL_GetRelativeMouseMode() == SDL_TRUE;
 }
 
-void Window::AggregateInput(WindowInput& input)
+void Window::AggregateInput(WindowInput& input, std::vector<SDL_Event>& uiEvents)
 {
-    ImGuiIO& io             = ImGui::GetIO();
-    bool     handleKeyboard = true;
-    bool     handleMouse    = true;
+    bool handleKeyboard = true;
+    bool handleMouse    = true;
 
     for (SDL_Event event; SDL_PollEvent(&event) != 0;)
     {
@@ -93,9 +90,9 @@ void Window::AggregateInput(WindowInput& input)
             break;
         }
 
-        ImGui_ImplSDL2_ProcessEvent(&event);
-        handleKeyboard = !io.WantCaptureKeyboard;
-        handleMouse    = !io.WantCaptureMouse;
+        uiEvents.push_back(event);
+        handleKeyboard = !m_uiCapturesKeyboard;
+        handleMouse    = !m_uiCapturesMouse;
 
         if (!handleMouse)
         {
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <legs/jolt_pch.hpp>
+
+namespace legs
+{
+
+/// Chase-Lev work stealing deque, following "Correct and Efficient Work-Stealing for Weak Memory
+/// Models" (Lê et al. 2013).
+///
+/// The owning thread pushes and pops at the bottom without contention, any other thread steals the
+/// oldest item from the top. Full queues grow instead of rejecting items. A thief can still be
+/// reading a buffer that was just replaced, so old buffers are only freed with the queue.
+template<class T>
+class WorkStealingQueue
+{
+  public:
+    explicit WorkStealingQueue(int64_t inCapacity = 1024)
+    {
+        JPH_ASSERT(inCapacity > 0 && JPH::IsPowerOf2(inCapacity));
+        mBuffers.push_back(std::make_unique<Buffer>(inCapacity));
+        mBuffer = mBuffers.back().get();
+    }
+
+    WorkStealingQueue(const WorkStealingQueue&)            = delete;
+    WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+    /// Owner only: add an item at the bottom
+    void Push(T* inItem)
+    {
+        int64_t bottom = mBottom.load(std::memory_order_relaxed);
+        int64_t top    = mTop.load(std::memory_order_acquire);
+        Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+
+        if (bottom - top >= buffer->mCapacity)
+        {
+            buffer = Grow(buffer, top, bottom);
+        }
+
+        buffer->Store(bottom, inItem);
+        std::atomic_thread_fence(std::memory_order_release);
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /// Owner only: take the most recently pushed item, nullptr if empty
+    T* Pop()
+    {
+        int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+        mBottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = mTop.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Was already empty
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = buffer->Load(bottom);
+        if (top == bottom)
+        {
+            // Last item, race thieves for it
+            if (!mTop.compare_exchange_strong(
+                    top,
+                    top + 1,
+                    std::memory_order_seq_cst,
+                    std::memory_order_relaxed
+                ))
+            {
+                item = nullptr;
+            }
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /// Any thread: take the oldest item, nullptr if empty or another thread got to it first
+    T* Steal()
+    {
+        int64_t top = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+        {
+            return nullptr;
+        }
+
+        Buffer* buffer = mBuffer.load(std::memory_order_acquire);
+        T*      item   = buffer->Load(top);
+        if (!mTop.compare_exchange_strong(
+                top,
+                top + 1,
+                std::memory_order_seq_cst,
+                std::memory_order_relaxed
+            ))
+        {
+            return nullptr;
+        }
+        return item;
+    }
+
+    /// Approximate, only exact when no other thread is using the queue
+    bool IsEmpty() const
+    {
+        return mBottom.load(std::memory_order_relaxed) <= mTop.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Buffer
+    {
+        explicit Buffer(int64_t inCapacity) :
+            mCapacity(inCapacity),
+            mItems(std::make_unique<std::atomic<T*>[]>(static_cast<size_t>(inCapacity)))
+        {
+        }
+
+        T* Load(int64_t inIndex) const
+        {
+            return mItems[static_cast<size_t>(inIndex & (mCapacity - 1))].load(
+                std::memory_order_relaxed
+            );
+        }
+
+        void Store(int64_t inIndex, T* inItem)
+        {
+            mItems[static_cast<size_t>(inIndex & (mCapacity - 1))].store(
+                inItem,
+                std::memory_order_relaxed
+            );
+        }
+
+        int64_t                            mCapacity;
+        std::unique_ptr<std::atomic<T*>[]> mItems;
+    };
+
+    /// Owner only: move the live range into a buffer twice the size
+    Buffer* Grow(Buffer* inBuffer, int64_t inTop, int64_t inBottom)
+    {
+        mBuffers.push_back(std::make_unique<Buffer>(inBuffer->mCapacity * 2));
+        Buffer* buffer = mBuffers.back().get();
+        for (int64_t i = inTop; i < inBottom; ++i)
+        {
+            buffer->Store(i, inBuffer->Load(i));
+        }
+        mBuffer.store(buffer, std::memory_order_release);
+        return buffer;
+    }
+
+    alignas(JPH_CACHE_LINE_SIZE) std::atomic<int64_t> mTop    = 0;
+    alignas(JPH_CACHE_LINE_SIZE) std::atomic<int64_t> mBottom = 0;
+    std::atomic<Buffer*> mBuffer;
+
+    /// Current and replaced buffers, owner only
+    std::vector<std::unique_ptr<Buffer>> mBuffers;
+};
+}; // namespace legs
@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <memory>
+#include <thread>
+#include <tuple>
 
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include "../physics.hpp"
 
@@ -8,14 +15,17 @@
 #include <legs/geometry/icosphere.hpp>
 #include <legs/log.hpp>
 #include <legs/renderer/renderer.hpp>
+#include <legs/time.hpp>
 #include <legs/world/world.hpp>
 
 namespace legs
 {
+static std::atomic<uint64_t> s_worldSerial = 0;
 
 World::World(std::shared_ptr<Renderer> renderer) :
     m_renderer(renderer),
-    m_physics(std::make_shared<Physics>())
+    m_physics(std::make_shared<Physics>()),
+    m_serial(++s_worldSerial)
 {
     LOG_DEBUG("Creating World");
 }
@@ -28,6 +38,7 @@ World::~World()
 
 void World::Frame()
 {
+    std::scoped_lock worldLock {m_worldMutex};
     for (auto ent : m_entities)
     {
         ent->OnFrame();
@@ -36,50 +47,469 @@ void World::Frame()
 
 void World::Tick()
 {
+    // Spawns from the frame thread and systems since the last tick.
+    ApplyCommands();
+
+    m_physics->Update();
+    m_time += Time::DeltaTick;
+
+    SyncPhysicsBodies();
+    IntegrateVelocities();
+
+    TickEntities();
+
+    // Spawns from this tick show up in its snapshot.
+    ApplyCommands();
+
+    // Nobody to consume it when headless.
+    if (m_renderer != nullptr)
     {
-        m_physics->Update();
+        PublishSnapshot();
+    }
+}
+
+void World::TickEntities()
+{
+    // Small enough batches to balance across workers,
+    // big enough that job overhead doesn't dominate trivial OnTicks.
+    static constexpr size_t MinBatchSize = 64;
 
-        std::scoped_lock worldLock {m_worldMutex};
-        for (auto ent : m_entities)
+    auto  jobSystem = m_physics->GetJobSystem();
+    auto& parallel  = m_parallelTickEntities.GetValues();
+
+    std::vector<JPH::JobHandle> jobs;
+    JPH::JobSystem::Barrier*    barrier = nullptr;
+    if (m_parallelTick && jobSystem != nullptr && parallel.size() > MinBatchSize)
+    {
+        const auto workers   = static_cast<size_t>(jobSystem->GetMaxConcurrency());
+        const auto batches   = workers * 4;
+        const auto batchSize = std::max(MinBatchSize, (parallel.size() + batches - 1) / batches);
+
+        jobs.reserve(batches);
+        barrier = jobSystem->CreateBarrier();
+        for (size_t begin = 0; begin < parallel.size(); begin += batchSize)
+        {
+            const auto end = std::min(begin + batchSize, parallel.size());
+            jobs.push_back(jobSystem->CreateJob(
+                "Entity OnTick",
+                JPH::Color::sGreen,
+                [&parallel, begin, end]()
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        parallel[i]->OnTick();
+                    }
+                }
+            ));
+        }
+        barrier->AddJobs(jobs.data(), static_cast<JPH::uint>(jobs.size()));
+    }
+    else
+    {
+        for (auto& ent : parallel)
         {
             ent->OnTick();
         }
     }
+
+    // Entities that aren't thread-safe run here while the workers are busy.
+    for (auto& ent : m_serialTickEntities)
+    {
+        ent->OnTick();
+    }
+
+    if (barrier != nullptr)
+    {
+        // Also runs queued batches on this thread.
+        jobSystem->WaitForJobs(barrier);
+        jobSystem->DestroyBarrier(barrier);
+    }
+}
+
+CommandBuffer& World::GetCommands()
+{
+    // Cache the last world this thread recorded into,
+    // the serial keeps a new world at a reused address from matching.
+    struct SCachedBuffer
+    {
+        uint64_t       serial = 0;
+        CommandBuffer* buffer = nullptr;
+    };
+    thread_local SCachedBuffer cached;
+
+    if (cached.serial == m_serial)
+    {
+        return *cached.buffer;
+    }
+
+    // Threads alternating between worlds miss the cache,
+    // reuse their buffer in this world instead of adding another.
+    const auto       thread = std::this_thread::get_id();
+    std::scoped_lock buffersLock {m_commandBuffersMutex};
+
+    cached.serial = m_serial;
+    for (size_t i = 0; i < m_commandBufferOwners.size(); i++)
+    {
+        if (m_commandBufferOwners[i] == thread)
+        {
+            cached.buffer = m_commandBuffers[i].get();
+            return *cached.buffer;
+        }
+    }
+
+    m_commandBufferOwners.push_back(thread);
+    cached.buffer =
+        m_commandBuffers.emplace_back(std::make_unique<CommandBuffer>(m_registry)).get();
+    return *cached.buffer;
+}
+
+void World::ApplyCommands()
+{
+    {
+        std::scoped_lock buffersLock {m_commandBuffersMutex};
+        m_applying.resize(m_commandBuffers.size());
+        for (size_t i = 0; i < m_commandBuffers.size(); i++)
+        {
+            m_commandBuffers[i]->Take(m_applying[i]);
+        }
+    }
+
+    std::scoped_lock worldLock {m_worldMutex};
+
+    // Apply each kind of change across all threads' buffers before the next,
+    // so every entity is spawned before anything touches it
+    // and despawns go last in a single sorted pass.
+    for (auto& commands : m_applying)
+    {
+        for (auto& spawn : commands.spawns)
+        {
+            spawn(m_registry);
+        }
+    }
+
+    for (auto& commands : m_applying)
+    {
+        for (auto& entity : commands.addedEntities)
+        {
+            ApplyAddEntity(entity);
+        }
+    }
+
+    for (auto& commands : m_applying)
+    {
+        for (auto& change : commands.changes)
+        {
+            change(m_registry);
+        }
+    }
+
+    for (auto& commands : m_applying)
+    {
+        for (auto& entity : commands.removedEntities)
+        {
+            ApplyRemoveEntity(entity);
+        }
+    }
+
+    m_despawns.clear();
+    for (auto& commands : m_applying)
+    {
+        m_despawns.insert(m_despawns.end(), commands.despawns.begin(), commands.despawns.end());
+    }
+
+    std::sort(m_despawns.begin(), m_despawns.end());
+    m_despawns.erase(std::unique(m_despawns.begin(), m_despawns.end()), m_despawns.end());
+    for (auto entity : m_despawns)
+    {
+        ApplyDestroyEntity(entity);
+    }
+}
+
+void World::SyncPhysicsBodies()
+{
+    m_registry.Each<STransform, const SPhysicsBody>(
+        [&](STransform& transform, const SPhysicsBody& body)
+        { m_physics->GetBodyTransform(body.id, transform); }
+    );
+}
+
+void World::IntegrateVelocities()
+{
+    const auto delta = static_cast<float>(Time::DeltaTick);
+    m_registry.Each<STransform, const SVelocity>(
+        Exclude<SPhysicsBody> {},
+        [&](STransform& transform, const SVelocity& velocity)
+        {
+            transform.position += velocity.linear * delta;
+
+            const auto angle = glm::length(velocity.angular) * delta;
+            if (angle > 0.0f)
+            {
+                const auto axis = glm::normalize(velocity.angular);
+                transform.rotation.quaternion =
+                    glm::angleAxis(angle, axis) * transform.rotation.quaternion;
+            }
+        }
+    );
 }
 
-void World::Render()
+void World::PublishSnapshot()
 {
+    auto& snapshot = m_snapshots.GetWriteBuffer();
+    snapshot.tick  = m_tickCount++;
+    snapshot.time  = m_time;
+
+    // Keep the vector's capacity around, slots get reused every third tick.
+    auto& meshEntities = m_meshEntities.GetValues();
+    snapshot.objects.resize(meshEntities.size());
+    for (size_t i = 0; i < meshEntities.size(); i++)
+    {
+        meshEntities[i]->Snapshot(snapshot.objects[i]);
+    }
+
+    m_registry.Each<const STransform, SMesh>(
+        [&](const STransform& transform, SMesh& mesh)
+        {
+            if (!mesh.hasSnapshot)
+            {
+                mesh.snapshotTransform = transform;
+                mesh.hasSnapshot       = true;
+            }
+
+            auto& object             = snapshot.objects.emplace_back();
+            object.previousTransform = mesh.snapshotTransform;
+            object.transform         = transform;
+            object.pipeline          = mesh.pipeline;
+            object.vertexBuffer      = mesh.vertexBuffer;
+            object.indexBuffer       = mesh.indexBuffer;
+            object.mesh              = mesh.mesh;
+            object.bounds            = mesh.bounds;
+            mesh.snapshotTransform   = transform;
+        }
+    );
+
+    m_snapshots.Publish();
+}
+
+void World::Render(double time)
+{
+    if (m_renderer == nullptr)
+    {
+        return;
+    }
+
+    // Latest complete tick, never blocks on or tears against the tick thread.
+    const auto& snapshot = m_snapshots.GetReadBuffer();
+
+    // Render one tick behind so there is always a pair of ticks to blend between,
+    // time past the latest snapshot is how far along from its previous transform we are.
+    const auto alpha = static_cast<float>(
+        std::clamp((time - snapshot.time) / Time::TickInterval, 0.0, 1.0)
+    );
+
+    // Objects with their own buffers get frustum culled here before anything is drawn,
+    // objects without bounds always pass.
+    // Arena meshes skip all of that, the GPU culls and batches them.
+    m_objectModels.resize(snapshot.objects.size());
+    m_renderOrder.clear();
+    m_cullSpheres.clear();
+    for (size_t i = 0; i < snapshot.objects.size(); i++)
+    {
+        const auto& object = snapshot.objects[i];
+        if (object.pipeline == RenderPipeline::INVALID || object.mesh != nullptr)
+        {
+            continue;
+        }
+
+        m_objectModels[i] = object.GetInterpolatedTransform(alpha).GetModelMatrix();
+        m_renderOrder.push_back(static_cast<uint32_t>(i));
+        m_cullSpheres.push_back(
+            object.bounds.has_value()
+                ? TransformBoundingSphere(*object.bounds, m_objectModels[i])
+                : glm::vec4(0.0f, 0.0f, 0.0f, std::numeric_limits<float>::infinity())
+        );
+    }
+
+    m_renderer->CullSpheres(m_cullSpheres, m_cullVisible);
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < m_renderOrder.size(); i++)
+    {
+        if (m_cullVisible[i])
+        {
+            m_renderOrder[visibleCount++] = m_renderOrder[i];
+        }
+    }
+    m_renderOrder.resize(visibleCount);
+
+    // Visible objects get sorted by pipeline, buffers and then distance,
+    // so objects sharing a pipeline and buffers end up next to each other front to back
+    // and each such group becomes a single instanced draw.
+    const auto cameraPosition = m_renderer->GetView().eye;
+    m_renderQueue.Clear();
+    for (auto index : m_renderOrder)
+    {
+        const auto& object = snapshot.objects[index];
+        const auto  depth  = glm::distance(cameraPosition, glm::vec3(m_objectModels[index][3]));
+        m_renderQueue.Submit(
+            RenderQueue::MakeKey(
+                static_cast<uint32_t>(object.pipeline),
+                object.vertexBuffer->GetId(),
+                object.indexBuffer->GetId(),
+                depth
+            ),
+            index
+        );
+    }
+    m_renderQueue.Sort();
+
+    const auto& packets = m_renderQueue.GetPackets();
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        m_renderOrder[i] = packets[i].object;
+    }
+
+    // Keys only hold part of the buffer ids, groups compare the buffers themselves.
+    auto meshKey = [&](uint32_t index)
+    {
+        const auto& object = snapshot.objects[index];
+        return std::make_tuple(
+            object.pipeline,
+            object.vertexBuffer.get(),
+            object.indexBuffer.get()
+        );
+    };
+
+    // Every object's model matrix goes up in a single write before anything is drawn,
+    // each group then draws its run of matrices by instance.
+    m_renderModels.resize(m_renderOrder.size());
+    for (size_t i = 0; i < m_renderOrder.size(); i++)
+    {
+        m_renderModels[i] = m_objectModels[m_renderOrder[i]];
+    }
+
+    // Culled draws pick their matrix by instance too, after the instanced groups.
+    for (const auto& object : snapshot.objects)
+    {
+        if (object.pipeline == RenderPipeline::INVALID || object.mesh == nullptr)
+        {
+            continue;
+        }
+
+        const auto model = static_cast<uint32_t>(m_renderModels.size());
+        m_renderModels.push_back(object.GetInterpolatedTransform(alpha).GetModelMatrix());
+        m_renderer->AddCulledObject(object.pipeline, object.mesh, model);
+    }
+    m_renderer->UpdateObjects(m_renderModels);
+
     if (m_sky != nullptr)
     {
         m_sky->Render(m_renderer);
     }
 
-    for (auto ent : m_entities)
+    m_draws.clear();
+    for (size_t first = 0; first < m_renderOrder.size();)
     {
-        if (auto meshEnt = std::static_pointer_cast<MeshEntity>(ent))
+        const auto key = meshKey(m_renderOrder[first]);
+
+        auto last = first + 1;
+        while (last < m_renderOrder.size() && meshKey(m_renderOrder[last]) == key)
         {
-            meshEnt->Render(m_renderer);
+            last++;
         }
+
+        const auto& object = snapshot.objects[m_renderOrder[first]];
+        m_draws.push_back({
+            object.pipeline,
+            object.vertexBuffer,
+            object.indexBuffer,
+            static_cast<uint32_t>(last - first),
+            static_cast<uint32_t>(first),
+        });
+        first = last;
     }
+
+    // Big scenes get recorded by the workers, the physics step shares them.
+    m_renderer->DrawList(m_draws, m_physics->GetJobSystem());
+
+    m_renderer->DrawCulled();
 }
 
 void World::AddEntity(std::shared_ptr<Entity> entity)
 {
-    m_entities.push_back(entity);
-    entity->OnSpawn();
+    GetCommands().AddEntity(entity);
 }
 
 void World::RemoveEntity(std::shared_ptr<Entity> entity)
 {
-    for (auto it = m_entities.begin(); it != m_entities.end();)
+    GetCommands().RemoveEntity(entity);
+}
+
+void World::DestroyEntity(EntityId entity)
+{
+    GetCommands().Despawn(entity);
+}
+
+void World::ApplyAddEntity(std::shared_ptr<Entity> entity)
+{
+    if (m_registry.IsAlive(entity->m_id))
     {
-        if (*it == entity)
-        {
-            m_entities.erase(it);
-            entity->OnDestroy();
-            break;
-        }
-        it++;
+        LOG_WARN("Tried to add an entity that is already spawned");
+        return;
+    }
+
+    // Legacy entities get a registry id too, so they can carry components.
+    entity->m_id = m_registry.Create();
+
+    m_entities.Insert(entity->m_id, entity);
+    if (entity->IsThreadSafe())
+    {
+        m_parallelTickEntities.Insert(entity->m_id, entity);
+    }
+    else
+    {
+        m_serialTickEntities.Insert(entity->m_id, entity);
     }
+    if (auto meshEntity = std::dynamic_pointer_cast<MeshEntity>(entity))
+    {
+        m_meshEntities.Insert(entity->m_id, meshEntity);
+    }
+    entity->OnSpawn();
+}
+
+void World::ApplyDestroyEntity(EntityId entity)
+{
+    if (!m_registry.IsAlive(entity))
+    {
+        return;
+    }
+
+    if (m_entities.Contains(entity))
+    {
+        LOG_WARN("Tried to destroy an Entity, use RemoveEntity instead");
+        return;
+    }
+
+    if (auto body = m_registry.TryGet<SPhysicsBody>(entity))
+    {
+        m_physics->RemoveBody(body->id);
+        m_physics->DestroyBody(body->id);
+    }
+    m_registry.Destroy(entity);
+}
+
+void World::ApplyRemoveEntity(std::shared_ptr<Entity> entity)
+{
+    const auto id = entity->m_id;
+    if (!m_entities.Erase(id))
+    {
+        return;
+    }
+
+    m_meshEntities.Erase(id);
+    m_serialTickEntities.Erase(id);
+    m_parallelTickEntities.Erase(id);
+    m_registry.Destroy(id);
+    entity->m_id = InvalidEntity;
+    entity->OnDestroy();
 }
 } // namespace legs